@@ -0,0 +1,566 @@
+//
+//  sqlite_tool_bench.cpp
+//  micro-benchmarks for every sqlite3_delegate operation
+//
+//  sqlite_tool_bench [--rows 1000,100000] [--db memory|file|both] [--dir .] [--repeat 5] [--json]
+//
+
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <new>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "sqlite_tool.hpp"
+
+/**
+ *every heap allocation in the process is counted, the benchmarks report the delta per row;
+ *the scalar and array forms are replaced together so every delete matches its new
+ */
+static std::atomic<size_t> allocation_count(0);
+
+static void *counted_alloc(size_t size) {
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    void *ptr = malloc(size == 0 ? 1 : size);
+    if (ptr == nullptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void *operator new(size_t size) {
+    return counted_alloc(size);
+}
+
+void *operator new[](size_t size) {
+    return counted_alloc(size);
+}
+
+void operator delete(void *ptr) noexcept {
+    free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept {
+    free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept {
+    free(ptr);
+}
+
+void operator delete[](void *ptr, size_t) noexcept {
+    free(ptr);
+}
+
+namespace {
+    using namespace sqlite_tool;
+
+    typedef std::chrono::steady_clock bench_clock;
+
+    struct bench_config {
+        std::vector<size_t> row_counts;
+        bool memory_db = true;
+        bool file_db = true;
+        std::string dir = ".";
+        size_t repeat = 5;
+        bool json = false;
+    };
+
+    struct bench_result {
+        std::string schema;
+        std::string db;
+        size_t rows = 0;
+        std::string operation;
+        size_t result_rows = 0;
+        double ops_per_sec = 0.0;
+        double p50_ns = 0.0;
+        double p90_ns = 0.0;
+        double p99_ns = 0.0;
+        double allocs_per_row = 0.0;
+    };
+
+    /**
+     *samples are per-row latencies in nanoseconds
+     */
+    class bench_recorder {
+    private:
+        std::vector<double> samples;
+        double total_ns = 0.0;
+        size_t total_rows = 0;
+        size_t allocations = 0;
+        size_t allocations_before = 0;
+        bench_clock::time_point started;
+    public:
+        void
+        start() {
+            allocations_before = allocation_count.load(std::memory_order_relaxed);
+            started = bench_clock::now();
+        }
+
+        void
+        stop(size_t rows) {
+            double elapsed = double(std::chrono::duration_cast<std::chrono::nanoseconds>(bench_clock::now() - started).count());
+            allocations += allocation_count.load(std::memory_order_relaxed) - allocations_before;
+            if (rows == 0) {
+                return;
+            }
+            total_ns += elapsed;
+            total_rows += rows;
+            samples.push_back(elapsed / double(rows));
+        }
+
+        void
+        fill(bench_result &result) {
+            if (samples.empty()) {
+                return;
+            }
+            std::sort(samples.begin(), samples.end());
+            auto percentile = [this](double p) {
+                size_t index = size_t(p * double(samples.size() - 1) + 0.5);
+                return samples.at(index);
+            };
+            result.ops_per_sec = total_ns > 0.0 ? double(total_rows) * 1e9 / total_ns : 0.0;
+            result.p50_ns = percentile(0.50);
+            result.p90_ns = percentile(0.90);
+            result.p99_ns = percentile(0.99);
+            result.allocs_per_row = double(allocations) / double(total_rows);
+        }
+    };
+
+    /**
+     *narrow: integers only
+     */
+    struct narrow_schema {
+        typedef sqlite3_delegate<integer, integer, integer, integer> delegate_type;
+        typedef std::tuple<integer, integer, integer, integer> row_type;
+
+        static const char *
+        name() {
+            return "narrow";
+        }
+
+        static size_t
+        scaled_rows(size_t rows) {
+            return rows;
+        }
+
+        static void
+        set_columns(delegate_type &delegate) {
+            delegate.set_column_names(std::string("id"), std::string("a"), std::string("b"), std::string("c"));
+        }
+
+        static row_type
+        make_row(size_t index) {
+            integer value = integer(index);
+            return row_type(value, value * 3, value * 7, value % 100);
+        }
+    };
+
+    /**
+     *mixed: one column of every storage class, short strings
+     */
+    struct mixed_schema {
+        typedef sqlite3_delegate<integer, real, char_string, data_string> delegate_type;
+        typedef std::tuple<integer, real, char_string, data_string> row_type;
+
+        static const char *
+        name() {
+            return "mixed";
+        }
+
+        static size_t
+        scaled_rows(size_t rows) {
+            return rows;
+        }
+
+        static void
+        set_columns(delegate_type &delegate) {
+            delegate.set_column_names(std::string("id"), std::string("amount"), std::string("label"), std::string("payload"));
+        }
+
+        static row_type
+        make_row(size_t index) {
+            const unsigned char payload[16] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16};
+            return row_type(integer(index), real(index) * 0.25, "label-" + std::to_string(index), data_string(payload, sizeof payload));
+        }
+    };
+
+    /**
+     *wide: eight columns with two 4 KiB blobs per row
+     */
+    struct wide_schema {
+        typedef sqlite3_delegate<integer, integer, real, real, char_string, char_string, data_string, data_string> delegate_type;
+        typedef std::tuple<integer, integer, real, real, char_string, char_string, data_string, data_string> row_type;
+
+        static const char *
+        name() {
+            return "wide";
+        }
+
+        /**
+         *rows carry 8 KiB of blobs, a tenth of the requested row count keeps memory bounded
+         */
+        static size_t
+        scaled_rows(size_t rows) {
+            return std::max<size_t>(1, rows / 10);
+        }
+
+        static void
+        set_columns(delegate_type &delegate) {
+            delegate.set_column_names(std::string("id"), std::string("i1"), std::string("r0"), std::string("r1"),
+                                      std::string("t0"), std::string("t1"), std::string("b0"), std::string("b1"));
+        }
+
+        static row_type
+        make_row(size_t index) {
+            data_string blob(4096, any_mem_t(index & 0xff));
+            return row_type(integer(index), integer(index * 2), real(index) * 0.5, real(index) * 1.5,
+                            "first text value " + std::to_string(index), "second text value " + std::to_string(index),
+                            blob, blob);
+        }
+    };
+
+    template<typename DELEGATE, typename ROW, size_t...index>
+    int
+    put_full_row(DELEGATE &delegate, const ROW &row, std::index_sequence<index...>) {
+        return delegate.put_row(std::make_pair(index, std::get<index>(row))...);
+    }
+
+    void
+    remove_db_files(const std::string &path) {
+        remove(path.c_str());
+        remove((path + "-wal").c_str());
+        remove((path + "-shm").c_str());
+        remove((path + "-journal").c_str());
+    }
+
+    template<typename SCHEMA>
+    class schema_bench {
+    private:
+        typedef typename SCHEMA::delegate_type delegate_type;
+        typedef typename SCHEMA::row_type row_type;
+
+        const bench_config &config;
+        std::vector<bench_result> &results;
+        std::string db_kind;
+        std::string db_path;
+        size_t rows;
+
+        void
+        open(delegate_type &delegate) {
+            if (db_path != ":memory:") {
+                remove_db_files(db_path);
+            }
+            /**
+             *commits are not synced, file runs measure the delegate and SQLite, not the disk
+             */
+            open_options options;
+            options.synchronous = open_options::synchronous_t::off;
+            delegate.set_db_file_path(db_path, options);
+            delegate.set_table_name(std::string("bench"));
+            SCHEMA::set_columns(delegate);
+            if (delegate.create_table_if_not_exists() != SQLITE_OK) {
+                fprintf(stderr, "create table failed for %s\n", db_path.c_str());
+                exit(1);
+            }
+        }
+
+        void
+        fill(delegate_type &delegate, const std::vector<row_type> &data) {
+            if (delegate.put_rows(data) != SQLITE_OK) {
+                fprintf(stderr, "put_rows failed for %s\n", db_path.c_str());
+                exit(1);
+            }
+        }
+
+        void
+        report(const char *operation, size_t result_rows, bench_recorder &recorder) {
+            bench_result result;
+            result.schema = SCHEMA::name();
+            result.db = db_kind;
+            result.rows = rows;
+            result.operation = operation;
+            result.result_rows = result_rows;
+            recorder.fill(result);
+            results.push_back(result);
+        }
+    public:
+        schema_bench(const bench_config &config, std::vector<bench_result> &results, std::string db_kind, std::string db_path, size_t rows)
+        : config(config), results(results), db_kind(std::move(db_kind)), db_path(std::move(db_path)), rows(SCHEMA::scaled_rows(rows)) {
+
+        }
+
+        void
+        run() {
+            std::vector<row_type> data;
+            data.reserve(rows);
+            for (size_t index = 0; index < rows; index++) {
+                data.push_back(SCHEMA::make_row(index));
+            }
+
+            {
+                /**
+                 *one sample per call
+                 */
+                delegate_type delegate;
+                open(delegate);
+                bench_recorder recorder;
+                for (const row_type &row : data) {
+                    recorder.start();
+                    put_full_row(delegate, row, std::make_index_sequence<std::tuple_size<row_type>::value>());
+                    recorder.stop(1);
+                }
+                report("put_row", rows, recorder);
+            }
+
+            {
+                bench_recorder recorder;
+                for (size_t round = 0; round < config.repeat; round++) {
+                    delegate_type target;
+                    open(target);
+                    recorder.start();
+                    target.put_rows(data);
+                    recorder.stop(rows);
+                }
+                report("put_rows", rows, recorder);
+            }
+
+            delegate_type delegate;
+            open(delegate);
+            fill(delegate, data);
+
+            {
+                bench_recorder recorder;
+                size_t returned = 0;
+                for (size_t round = 0; round < config.repeat; round++) {
+                    std::deque<sqlite3_row> all;
+                    recorder.start();
+                    delegate.get_all(all);
+                    returned = all.size();
+                    recorder.stop(returned);
+                }
+                report("get_all", returned, recorder);
+            }
+
+            {
+                bench_recorder recorder;
+                size_t returned = 0;
+                sqlite3_result_set all;
+                for (size_t round = 0; round < config.repeat; round++) {
+                    recorder.start();
+                    delegate.get_all(all);
+                    returned = all.size();
+                    recorder.stop(returned);
+                }
+                report("get_all(result_set)", returned, recorder);
+            }
+
+            {
+                bench_recorder recorder;
+                size_t returned = 0;
+                for (size_t round = 0; round < config.repeat; round++) {
+                    recorder.start();
+                    auto values = delegate.template get_column_value<0>();
+                    returned = values.size();
+                    recorder.stop(returned);
+                }
+                report("get_column_value<0>", returned, recorder);
+            }
+
+            {
+                bench_recorder recorder;
+                size_t returned = 0;
+                for (size_t round = 0; round < config.repeat; round++) {
+                    recorder.start();
+                    auto values = delegate.template get_column_value<0, 1, 2, 3>();
+                    returned = values.size();
+                    recorder.stop(returned);
+                }
+                report("get_column_value<0,1,2,3>", returned, recorder);
+            }
+
+            {
+                bench_recorder recorder;
+                size_t returned = 0;
+                for (size_t round = 0; round < config.repeat; round++) {
+                    typename delegate_type::template columnar_type<0, 1> values;
+                    recorder.start();
+                    delegate.template get_columnar<0, 1>(values);
+                    returned = values.size();
+                    recorder.stop(returned);
+                }
+                report("get_columnar<0,1>", returned, recorder);
+            }
+
+            {
+                bench_recorder recorder;
+                size_t returned = 0;
+                for (size_t round = 0; round < config.repeat; round++) {
+                    recorder.start();
+                    for (auto &&row : delegate.template scan<0, 1>()) {
+                        (void)row;
+                        returned++;
+                    }
+                    recorder.stop(returned);
+                    returned = 0;
+                }
+                report("scan<0,1>", rows, recorder);
+            }
+
+            {
+                bench_recorder recorder;
+                size_t returned = 0;
+                for (size_t round = 0; round < config.repeat; round++) {
+                    recorder.start();
+                    delegate.template visit<0, 1, 2, 3>([&](const auto &...) {
+                        returned++;
+                    });
+                    recorder.stop(returned);
+                    returned = 0;
+                }
+                report("visit<0,1,2,3>", rows, recorder);
+            }
+
+            {
+                bench_recorder recorder;
+                size_t returned = 0;
+                for (size_t round = 0; round < config.repeat; round++) {
+                    decltype(delegate.template get_column_value<0, 1>()) values;
+                    recorder.start();
+                    delegate.template get_column_value_parallel<0, 1>(values);
+                    returned = values.size();
+                    recorder.stop(returned);
+                }
+                report("get_column_value_parallel<0,1>", returned, recorder);
+            }
+
+            /**
+             *result sizes: about 1% and 10% of the table
+             */
+            const size_t selective[] = {rows / 100, rows / 10};
+            const char *selective_names[] = {"get_column_value_match_conditions<0,1> 1%", "get_column_value_match_conditions<0,1> 10%"};
+            for (size_t kind = 0; kind < 2; kind++) {
+                bench_recorder recorder;
+                size_t returned = 0;
+                for (size_t round = 0; round < config.repeat; round++) {
+                    recorder.start();
+                    auto values = delegate.template get_column_value_match_conditions<0, 1>(col<0>() < integer(selective[kind]));
+                    returned = values.size();
+                    recorder.stop(returned);
+                }
+                report(selective_names[kind], returned, recorder);
+            }
+
+            {
+                /**
+                 *point updates without an index, so each one is a table scan: keep the count small
+                 */
+                bench_recorder recorder;
+                size_t updates = std::min<size_t>(rows, 100);
+                for (size_t index = 0; index < updates; index++) {
+                    size_t target = (index * 7919) % rows;
+                    recorder.start();
+                    delegate.update_column_value_match_conditions(col<0>() == integer(target),
+                                                                  std::make_pair(size_t(1), std::get<1>(SCHEMA::make_row(target + 1))));
+                    recorder.stop(1);
+                }
+                report("update_column_value_match_conditions", updates, recorder);
+            }
+        }
+    };
+
+    std::vector<size_t>
+    parse_row_counts(const char *list) {
+        std::vector<size_t> counts;
+        const char *cursor = list;
+        while (*cursor != '\0') {
+            char *end = nullptr;
+            unsigned long long count = strtoull(cursor, &end, 10);
+            if (end == cursor) {
+                break;
+            }
+            if (count > 0) {
+                counts.push_back(size_t(count));
+            }
+            cursor = *end == ',' ? end + 1 : end;
+        }
+        return counts;
+    }
+
+    void
+    print_results(const bench_config &config, const std::vector<bench_result> &results) {
+        if (config.json) {
+            for (const bench_result &result : results) {
+                printf("{\"schema\":\"%s\",\"db\":\"%s\",\"rows\":%zu,\"operation\":\"%s\",\"result_rows\":%zu,"
+                       "\"ops_per_sec\":%.1f,\"p50_ns\":%.1f,\"p90_ns\":%.1f,\"p99_ns\":%.1f,\"allocs_per_row\":%.3f}\n",
+                       result.schema.c_str(), result.db.c_str(), result.rows, result.operation.c_str(), result.result_rows,
+                       result.ops_per_sec, result.p50_ns, result.p90_ns, result.p99_ns, result.allocs_per_row);
+            }
+            return;
+        }
+        printf("%-7s %-7s %8s  %-44s %8s %14s %10s %10s %10s %10s\n",
+               "schema", "db", "rows", "operation", "result", "rows/sec", "p50 ns", "p90 ns", "p99 ns", "allocs/row");
+        for (const bench_result &result : results) {
+            printf("%-7s %-7s %8zu  %-44s %8zu %14.1f %10.1f %10.1f %10.1f %10.3f\n",
+                   result.schema.c_str(), result.db.c_str(), result.rows, result.operation.c_str(), result.result_rows,
+                   result.ops_per_sec, result.p50_ns, result.p90_ns, result.p99_ns, result.allocs_per_row);
+        }
+    }
+
+    template<typename SCHEMA>
+    void
+    run_schema(const bench_config &config, std::vector<bench_result> &results) {
+        for (size_t rows : config.row_counts) {
+            if (config.memory_db) {
+                schema_bench<SCHEMA>(config, results, "memory", ":memory:", rows).run();
+            }
+            if (config.file_db) {
+                std::string path = config.dir + "/sqlite_tool_bench.db";
+                schema_bench<SCHEMA>(config, results, "file", path, rows).run();
+                remove_db_files(path);
+            }
+        }
+    }
+}
+
+int main(int argc, char *argv[]) {
+    bench_config config;
+    config.row_counts.push_back(1000);
+    config.row_counts.push_back(100000);
+    for (int index = 1; index < argc; index++) {
+        std::string arg(argv[index]);
+        bool has_value = index + 1 < argc;
+        if (arg == "--rows" && has_value) {
+            config.row_counts = parse_row_counts(argv[++index]);
+        }
+        else if (arg == "--db" && has_value) {
+            std::string kind(argv[++index]);
+            config.memory_db = kind == "memory" || kind == "both";
+            config.file_db = kind == "file" || kind == "both";
+        }
+        else if (arg == "--dir" && has_value) {
+            config.dir = argv[++index];
+        }
+        else if (arg == "--repeat" && has_value) {
+            config.repeat = std::max<size_t>(1, size_t(strtoull(argv[++index], nullptr, 10)));
+        }
+        else if (arg == "--json") {
+            config.json = true;
+        }
+        else {
+            fprintf(stderr, "usage: %s [--rows 1000,100000] [--db memory|file|both] [--dir .] [--repeat 5] [--json]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    std::vector<bench_result> results;
+    run_schema<narrow_schema>(config, results);
+    run_schema<mixed_schema>(config, results);
+    run_schema<wide_schema>(config, results);
+    print_results(config, results);
+    return 0;
+}
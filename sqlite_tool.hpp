@@ -5,11 +5,32 @@
 
 #include <stdio.h>
 #include <stdarg.h>
+#include <stdlib.h>
 #include <iostream>
 #include <vector>
 #include <deque>
 #include <tuple>
 #include <utility>
+#include <array>
+#include <string>
+#include <list>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <future>
+#include <condition_variable>
+#include <functional>
+#include <chrono>
+#include <cstdint>
+#include <iterator>
+#include <algorithm>
+#include <type_traits>
+#include <typeinfo>
+#include <stdexcept>
+#include <cstring>
+#include <cerrno>
 
 #if defined(_WIN32) || defined(_WIN64)
 #include <io.h>
@@ -36,6 +57,27 @@ if (file != nullptr)\
 
 #include "sqlite3.h"
 
+/**
+ *per-operation timing and counters (operation_probe), 0 compiles every probe to an empty inline call
+ */
+#ifndef SQLXX_INSTRUMENTATION
+#define SQLXX_INSTRUMENTATION 0
+#endif
+
+#if __cplusplus >= 201703L || (defined(_MSVC_LANG) && _MSVC_LANG >= 201703L)
+#define SQLXX_HAS_CXX17 1
+#include <string_view>
+#else
+#define SQLXX_HAS_CXX17 0
+#endif
+
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L
+#define SQLXX_HAS_COROUTINES 1
+#include <coroutine>
+#else
+#define SQLXX_HAS_COROUTINES 0
+#endif
+
 namespace sqlite_tool {
     typedef std::string char_string;
     using any_mem_t = unsigned char;
@@ -43,6 +85,200 @@ namespace sqlite_tool {
     typedef sqlite3_int64 integer;
     typedef double real;
     
+    /**
+     *read-only view of a BLOB column, points into SQLite's row buffer and is valid only until the next step
+     */
+    class blob_view {
+    private:
+        const any_mem_t *bytes = nullptr;
+        size_t length = 0;
+    public:
+        blob_view() {
+            
+        }
+        
+        blob_view(const any_mem_t *bytes, size_t length) : bytes(bytes), length(length) {
+            
+        }
+        
+        const any_mem_t *data() const { return bytes; }
+        size_t size() const { return length; }
+        bool empty() const { return length == 0; }
+        const any_mem_t *begin() const { return bytes; }
+        const any_mem_t *end() const { return bytes + length; }
+        any_mem_t operator[](size_t index) const { return bytes[index]; }
+    };
+    
+    /**
+     *value for a BLOB column that reserves bytes zero bytes without building them in memory,
+     *fill it afterwards through blob_stream
+     */
+    struct zero_blob {
+        size_t bytes;
+        
+        explicit zero_blob(size_t bytes) : bytes(bytes) {
+            
+        }
+    };
+    
+    /**
+     *incremental I/O on one BLOB (or TEXT) value, ranges are read and written in place without
+     *loading the value; reopen moves the same handle to another row of the table. A handle on a
+     *row that is changed or deleted by other means is expired and every call returns SQLITE_ABORT
+     */
+    class blob_stream {
+    private:
+        sqlite3_blob *blob = nullptr;
+        size_t blob_size = 0;
+        
+        void
+        blob_stream_rv(blob_stream &&obj) {
+            std::swap(blob, obj.blob);
+            std::swap(blob_size, obj.blob_size);
+        }
+        
+        SQLITE_API int SQLITE_STDCALL
+        check_range(size_t bytes, size_t offset) const {
+            if (blob == nullptr) {
+                return SQLITE_MISUSE;
+            }
+            if (offset > blob_size || bytes > blob_size - offset) {
+                return SQLITE_RANGE;
+            }
+            return SQLITE_OK;
+        }
+    public:
+        blob_stream() {
+            
+        }
+        
+        ~blob_stream() {
+            close();
+        }
+        
+        blob_stream(const blob_stream &) = delete;
+        blob_stream(blob_stream &&obj) {
+            blob_stream_rv(std::forward<blob_stream>(obj));
+        }
+        
+        blob_stream &operator=(const blob_stream &) = delete;
+        blob_stream &operator=(blob_stream &&obj) {
+            blob_stream_rv(std::forward<blob_stream>(obj));
+            return *this;
+        }
+        
+        /**
+         *writable handles may only overwrite bytes, the size is fixed when the value is written
+         */
+        SQLITE_API int SQLITE_STDCALL
+        open(sqlite3 *db, const std::string &table, const std::string &column, integer rowid, bool writable) {
+            close();
+            SQLITE_API int SQLITE_STDCALL open_err = sqlite3_blob_open(db, "main", table.c_str(), column.c_str(), rowid, writable ? 1 : 0, &blob);
+            if (open_err != SQLITE_OK) {
+                close();
+                return open_err;
+            }
+            blob_size = size_t(sqlite3_blob_bytes(blob));
+            return SQLITE_OK;
+        }
+        
+        /**
+         *same table, column and mode on another row, cheaper than close and open
+         */
+        SQLITE_API int SQLITE_STDCALL
+        reopen(integer rowid) {
+            if (blob == nullptr) {
+                return SQLITE_MISUSE;
+            }
+            SQLITE_API int SQLITE_STDCALL reopen_err = sqlite3_blob_reopen(blob, rowid);
+            blob_size = reopen_err == SQLITE_OK ? size_t(sqlite3_blob_bytes(blob)) : 0;
+            return reopen_err;
+        }
+        
+        void
+        close() {
+            if (blob != nullptr) {
+                sqlite3_blob_close(blob);
+                blob = nullptr;
+            }
+            blob_size = 0;
+        }
+        
+        bool
+        is_open() const {
+            return blob != nullptr;
+        }
+        
+        size_t
+        size() const {
+            return blob_size;
+        }
+        
+        SQLITE_API int SQLITE_STDCALL
+        read(void *buffer, size_t bytes, size_t offset) {
+            SQLITE_API int SQLITE_STDCALL range_err = check_range(bytes, offset);
+            if (range_err != SQLITE_OK) {
+                return range_err;
+            }
+            return sqlite3_blob_read(blob, buffer, int(bytes), int(offset));
+        }
+        
+        SQLITE_API int SQLITE_STDCALL
+        write(const void *buffer, size_t bytes, size_t offset) {
+            SQLITE_API int SQLITE_STDCALL range_err = check_range(bytes, offset);
+            if (range_err != SQLITE_OK) {
+                return range_err;
+            }
+            return sqlite3_blob_write(blob, buffer, int(bytes), int(offset));
+        }
+    };
+    
+#if SQLXX_HAS_CXX17
+    typedef std::string_view text_view;
+#else
+    /**
+     *stand-in for std::string_view before C++17, same lifetime rule as blob_view
+     */
+    class text_view {
+    private:
+        const char *chars = nullptr;
+        size_t length = 0;
+    public:
+        text_view() {
+            
+        }
+        
+        text_view(const char *chars, size_t length) : chars(chars), length(length) {
+            
+        }
+        
+        const char *data() const { return chars; }
+        size_t size() const { return length; }
+        bool empty() const { return length == 0; }
+        const char *begin() const { return chars; }
+        const char *end() const { return chars + length; }
+        char operator[](size_t index) const { return chars[index]; }
+    };
+#endif
+    
+    /**
+     *type a visit callback receives for a column type: TEXT/BLOB as views, numbers by value
+     */
+    template<typename T>
+    struct column_view {
+        typedef T type;
+    };
+    
+    template<>
+    struct column_view<char_string> {
+        typedef text_view type;
+    };
+    
+    template<>
+    struct column_view<data_string> {
+        typedef blob_view type;
+    };
+    
     class sqlite3_row {
     public:
         /**
@@ -50,6 +286,8 @@ namespace sqlite_tool {
          */
         typedef std::tuple<size_t, size_t, size_t, const std::type_info &> column_info;
     private:
+        friend class row_decode_plan;
+        
         size_t row_mem_size = 0;
         unsigned char *data = nullptr;
         std::vector<sqlite3_row::column_info> row_info;
@@ -77,19 +315,18 @@ namespace sqlite_tool {
             if (data == nullptr) {
                 return;
             }
+            /**
+             *strings are destroyed where they were constructed, a bytewise copy of a
+             *std::basic_string is not a valid object (the short string buffer points into itself)
+             */
             for (const column_info &col_inf : row_info) {
-                size_t offset, length;
-                std::tie(offset, length, std::ignore, std::ignore) = col_inf;
+                size_t offset = std::get<0>(col_inf);
                 const std::type_info &type = std::get<3>(col_inf);
                 if (type == typeid(char_string)) {
-                    void *buf = operator new(length);
-                    memmove(buf, data + offset, length);
-                    delete reinterpret_cast<char_string *>(buf);
+                    reinterpret_cast<char_string *>(data + offset)->~char_string();
                 }
                 else if (type == typeid(data_string)) {
-                    void *buf = operator new(length);
-                    memmove(buf, data + offset, length);
-                    delete reinterpret_cast<data_string *>(buf);
+                    reinterpret_cast<data_string *>(data + offset)->~data_string();
                 }
             }
             operator delete(data);
@@ -167,22 +404,46 @@ namespace sqlite_tool {
     
     class stmt_utility {
     public:
+#if SQLXX_INSTRUMENTATION
+        /**
+         *bytes copied out of result rows by this thread
+         */
+        static size_t &
+        copied_bytes() {
+            static thread_local size_t bytes = 0;
+            return bytes;
+        }
+#endif
+        
         void
         static stmt_get_column(sqlite3_stmt *stmtptr, size_t col, integer &val) {
             SQLITE_API sqlite3_int64 SQLITE_STDCALL value = sqlite3_column_int64(stmtptr, int(col));
             val = value;
+#if SQLXX_INSTRUMENTATION
+            copied_bytes() += sizeof(val);
+#endif
         }
         
         void
         static stmt_get_column(sqlite3_stmt *stmtptr, size_t col, double &val) {
             SQLITE_API double SQLITE_STDCALL value = sqlite3_column_double(stmtptr, int(col));
             val = value;
+#if SQLXX_INSTRUMENTATION
+            copied_bytes() += sizeof(val);
+#endif
         }
         
         void
         static stmt_get_column(sqlite3_stmt *stmtptr, size_t col, char_string &val) {
             SQLITE_API const unsigned char * SQLITE_STDCALL value = sqlite3_column_text(stmtptr, int(col));
             SQLITE_API int SQLITE_STDCALL bytes = sqlite3_column_bytes(stmtptr, int(col));
+#if SQLXX_INSTRUMENTATION
+            copied_bytes() += size_t(bytes);
+#endif
+            if (value == nullptr) {
+                val.clear();
+                return;
+            }
             char_string value_string(reinterpret_cast<const char *>(value), bytes);
             val = std::move(value_string);
         }
@@ -191,10 +452,31 @@ namespace sqlite_tool {
         static stmt_get_column(sqlite3_stmt *stmtptr, size_t col, data_string &val) {
             SQLITE_API const void * SQLITE_STDCALL value = sqlite3_column_blob(stmtptr, int(col));
             SQLITE_API int SQLITE_STDCALL bytes = sqlite3_column_bytes(stmtptr, int(col));
+#if SQLXX_INSTRUMENTATION
+            copied_bytes() += size_t(bytes);
+#endif
+            if (value == nullptr) {
+                val.clear();
+                return;
+            }
             data_string value_string(reinterpret_cast<const unsigned char *>(value), bytes);
             val = std::move(value_string);
         }
         
+        void
+        static stmt_get_column(sqlite3_stmt *stmtptr, size_t col, text_view &val) {
+            SQLITE_API const unsigned char * SQLITE_STDCALL value = sqlite3_column_text(stmtptr, int(col));
+            SQLITE_API int SQLITE_STDCALL bytes = sqlite3_column_bytes(stmtptr, int(col));
+            val = value == nullptr ? text_view() : text_view(reinterpret_cast<const char *>(value), size_t(bytes));
+        }
+        
+        void
+        static stmt_get_column(sqlite3_stmt *stmtptr, size_t col, blob_view &val) {
+            SQLITE_API const void * SQLITE_STDCALL value = sqlite3_column_blob(stmtptr, int(col));
+            SQLITE_API int SQLITE_STDCALL bytes = sqlite3_column_bytes(stmtptr, int(col));
+            val = blob_view(reinterpret_cast<const any_mem_t *>(value), size_t(bytes));
+        }
+        
         template<typename T>
         T
         static stmt_get_column(sqlite3_stmt *stmtptr, size_t col) {
@@ -212,6 +494,353 @@ namespace sqlite_tool {
         }
     };
     
+    /**
+     *how every result column lands in a sqlite3_row, worked out once per statement from the row
+     *descriptor: each column is read as the type of its slot, so a row needs no sqlite3_column_type
+     *switch and a NULL reads as 0 or an empty value like in sqlite3_result_set
+     */
+    class row_decode_plan {
+    private:
+        typedef void (*column_decoder)(sqlite3_stmt *, int, unsigned char *);
+        
+        struct column_step {
+            column_decoder decode;
+            size_t offset;
+        };
+        
+        std::vector<column_step> steps;
+        
+        template<typename T>
+        static void
+        decode_column(sqlite3_stmt *stmt, int col, unsigned char *slot) {
+            stmt_utility::stmt_get_column(stmt, size_t(col), *reinterpret_cast<T *>(slot));
+        }
+        
+        /**
+         *a NULL BLOB has always read back as a single zero byte
+         */
+        static void
+        decode_blob_column(sqlite3_stmt *stmt, int col, unsigned char *slot) {
+            data_string &value = *reinterpret_cast<data_string *>(slot);
+            if (sqlite3_column_type(stmt, col) == SQLITE_NULL) {
+                value.assign(1, 0);
+                return;
+            }
+            stmt_utility::stmt_get_column(stmt, size_t(col), value);
+        }
+    public:
+        /**
+         *SQLITE_SCHEMA when the statement's columns are not the descriptor's
+         */
+        SQLITE_API int SQLITE_STDCALL
+        build(sqlite3_stmt *stmt, const std::vector<sqlite3_row::column_info> &schema) {
+            steps.clear();
+            if (size_t(sqlite3_column_count(stmt)) != schema.size()) {
+                return SQLITE_SCHEMA;
+            }
+            for (const sqlite3_row::column_info &col_inf : schema) {
+                const std::type_info &type = std::get<3>(col_inf);
+                column_step step;
+                step.offset = std::get<0>(col_inf);
+                if (type == typeid(integer)) {
+                    step.decode = &row_decode_plan::decode_column<integer>;
+                }
+                else if (type == typeid(real)) {
+                    step.decode = &row_decode_plan::decode_column<real>;
+                }
+                else if (type == typeid(char_string)) {
+                    step.decode = &row_decode_plan::decode_column<char_string>;
+                }
+                else if (type == typeid(data_string)) {
+                    step.decode = &row_decode_plan::decode_blob_column;
+                }
+                else {
+                    steps.clear();
+                    return SQLITE_MISMATCH;
+                }
+                steps.push_back(step);
+            }
+            return SQLITE_OK;
+        }
+        
+        /**
+         *row must have been created from the descriptor the plan was built from
+         */
+        void
+        decode(sqlite3_stmt *stmt, sqlite3_row &row) const {
+            for (size_t index = 0; index < steps.size(); index++) {
+                steps[index].decode(stmt, int(index), row.data + steps[index].offset);
+            }
+        }
+    };
+    
+    /**
+     *rows of one query packed into shared storage: fixed-width slots live in arena chunks,
+     *TEXT/BLOB bytes in a slab, and every row uses the same column descriptor;
+     *NULL reads back as 0 or an empty value
+     */
+    class sqlite3_result_set {
+    public:
+        typedef sqlite3_row::column_info column_info;
+        
+        enum class column_kind {
+            integer_column,
+            real_column,
+            text_column,
+            blob_column
+        };
+        
+        class row_ref {
+        private:
+            const sqlite3_result_set *set;
+            const unsigned char *data;
+        public:
+            row_ref(const sqlite3_result_set *set, const unsigned char *data) : set(set), data(data) {
+                
+            }
+            
+            integer
+            get_integer(size_t index) const {
+                integer value;
+                memcpy(&value, data + set->checked_slot(index, column_kind::integer_column), sizeof(value));
+                return value;
+            }
+            
+            real
+            get_real(size_t index) const {
+                real value;
+                memcpy(&value, data + set->checked_slot(index, column_kind::real_column), sizeof(value));
+                return value;
+            }
+            
+            /**
+             *points into the result set, valid until it is cleared or destroyed
+             */
+            const char *
+            get_text(size_t index, size_t *size) const {
+                bytes_ref ref;
+                memcpy(&ref, data + set->checked_slot(index, column_kind::text_column), sizeof(ref));
+                *size = ref.size;
+                return reinterpret_cast<const char *>(ref.bytes);
+            }
+            
+            const any_mem_t *
+            get_blob(size_t index, size_t *size) const {
+                bytes_ref ref;
+                memcpy(&ref, data + set->checked_slot(index, column_kind::blob_column), sizeof(ref));
+                *size = ref.size;
+                return ref.bytes;
+            }
+            
+            /**
+             *copying accessor with the same types as sqlite3_row::get_column
+             */
+            template<typename T>
+            T get_column(size_t index) const {
+                T value;
+                read(index, value);
+                return value;
+            }
+        private:
+            void
+            read(size_t index, integer &value) const {
+                value = get_integer(index);
+            }
+            
+            void
+            read(size_t index, real &value) const {
+                value = get_real(index);
+            }
+            
+            void
+            read(size_t index, char_string &value) const {
+                size_t size = 0;
+                const char *text = get_text(index, &size);
+                value.assign(text, size);
+            }
+            
+            void
+            read(size_t index, data_string &value) const {
+                size_t size = 0;
+                const any_mem_t *blob = get_blob(index, &size);
+                value.assign(blob, size);
+            }
+        };
+    private:
+        struct bytes_ref {
+            const any_mem_t *bytes;
+            size_t size;
+        };
+        
+        struct column_slot {
+            size_t offset;
+            column_kind kind;
+        };
+        
+        static const size_t row_chunk_bytes = 64 * 1024;
+        static const size_t slab_chunk_bytes = 1024 * 1024;
+        
+        std::vector<column_slot> slots;
+        size_t row_stride = 0;
+        size_t rows_per_chunk = 0;
+        size_t row_count = 0;
+        std::vector<std::unique_ptr<unsigned char[]>> row_chunks;
+        std::vector<std::unique_ptr<any_mem_t[]>> slab_chunks;
+        any_mem_t *slab_cursor = nullptr;
+        size_t slab_left = 0;
+        
+        size_t
+        checked_slot(size_t index, column_kind kind) const {
+            const column_slot &slot = slots.at(index);
+            if (slot.kind != kind) {
+                throw std::bad_cast();
+            }
+            return slot.offset;
+        }
+        
+        const any_mem_t *
+        copy_bytes(const void *bytes, size_t size) {
+            static const any_mem_t no_bytes = 0;
+            if (size == 0) {
+                return &no_bytes;
+            }
+            if (size > slab_left) {
+                size_t chunk_size = size > slab_chunk_bytes ? size : slab_chunk_bytes;
+                slab_chunks.emplace_back(new any_mem_t[chunk_size]);
+                slab_cursor = slab_chunks.back().get();
+                slab_left = chunk_size;
+            }
+            any_mem_t *target = slab_cursor;
+            memcpy(target, bytes, size);
+            slab_cursor += size;
+            slab_left -= size;
+            return target;
+        }
+    public:
+        sqlite3_result_set() {
+            
+        }
+        
+        sqlite3_result_set(const sqlite3_result_set &) = delete;
+        sqlite3_result_set &operator=(const sqlite3_result_set &) = delete;
+        sqlite3_result_set(sqlite3_result_set &&) = default;
+        sqlite3_result_set &operator=(sqlite3_result_set &&) = default;
+        
+        /**
+         *drops all rows and storage in one step and takes the column types from the row descriptor
+         */
+        void
+        reset(const std::vector<column_info> &schema) {
+            clear();
+            slots.clear();
+            row_stride = 0;
+            for (const column_info &col_inf : schema) {
+                const std::type_info &type = std::get<3>(col_inf);
+                column_slot slot;
+                slot.offset = row_stride;
+                if (type == typeid(integer)) {
+                    slot.kind = column_kind::integer_column;
+                    row_stride += sizeof(integer);
+                }
+                else if (type == typeid(real)) {
+                    slot.kind = column_kind::real_column;
+                    row_stride += sizeof(real);
+                }
+                else {
+                    slot.kind = type == typeid(char_string) ? column_kind::text_column : column_kind::blob_column;
+                    row_stride += sizeof(bytes_ref);
+                }
+                slots.push_back(slot);
+            }
+            rows_per_chunk = row_stride == 0 ? 1 : (row_chunk_bytes + row_stride - 1) / row_stride;
+        }
+        
+        void
+        clear() {
+            row_chunks.clear();
+            slab_chunks.clear();
+            slab_cursor = nullptr;
+            slab_left = 0;
+            row_count = 0;
+        }
+        
+        size_t
+        size() const {
+            return row_count;
+        }
+        
+        bool
+        empty() const {
+            return row_count == 0;
+        }
+        
+        size_t
+        column_count() const {
+            return slots.size();
+        }
+        
+        column_kind
+        kind(size_t index) const {
+            return slots.at(index).kind;
+        }
+        
+        row_ref
+        operator[](size_t row) const {
+            return row_ref(this, row_chunks[row / rows_per_chunk].get() + (row % rows_per_chunk) * row_stride);
+        }
+        
+        row_ref
+        at(size_t row) const {
+            if (row >= row_count) {
+                throw std::out_of_range("sqlite3_result_set::at");
+            }
+            return (*this)[row];
+        }
+        
+        /**
+         *copies the current row of stmt, result column i is schema column i
+         */
+        void
+        append(sqlite3_stmt *stmt) {
+            if (row_count % rows_per_chunk == 0) {
+                row_chunks.emplace_back(new unsigned char[rows_per_chunk * row_stride]);
+            }
+            unsigned char *data = row_chunks.back().get() + (row_count % rows_per_chunk) * row_stride;
+            for (size_t index = 0; index < slots.size(); index++) {
+                const column_slot &slot = slots[index];
+                int col = int(index);
+                switch (slot.kind) {
+                    case column_kind::integer_column: {
+                        integer value = sqlite3_column_int64(stmt, col);
+                        memcpy(data + slot.offset, &value, sizeof(value));
+                        break;
+                    }
+                    case column_kind::real_column: {
+                        real value = sqlite3_column_double(stmt, col);
+                        memcpy(data + slot.offset, &value, sizeof(value));
+                        break;
+                    }
+                    case column_kind::text_column:
+                    case column_kind::blob_column: {
+                        const void *bytes = slot.kind == column_kind::text_column ? static_cast<const void *>(sqlite3_column_text(stmt, col)) : sqlite3_column_blob(stmt, col);
+                        bytes_ref ref;
+                        ref.size = size_t(sqlite3_column_bytes(stmt, col));
+                        ref.bytes = copy_bytes(bytes, ref.size);
+#if SQLXX_INSTRUMENTATION
+                        stmt_utility::copied_bytes() += ref.size;
+#endif
+                        memcpy(data + slot.offset, &ref, sizeof(ref));
+                        break;
+                    }
+                }
+            }
+#if SQLXX_INSTRUMENTATION
+            stmt_utility::copied_bytes() += row_stride;
+#endif
+            row_count++;
+        }
+    };
+    
     class bind_utility {
     public:
         /**
@@ -262,6 +891,15 @@ namespace sqlite_tool {
             return bind_err;
         }
         
+        SQLITE_API int SQLITE_STDCALL 
+        static bind_value(sqlite3_stmt *stmt, const std::pair<std::string, zero_blob> &column_value_pair) {
+            std::string parameter_name("$");
+            parameter_name.append(column_value_pair.first);
+            SQLITE_API int SQLITE_STDCALL index = sqlite3_bind_parameter_index(stmt, parameter_name.c_str());
+            SQLITE_API int SQLITE_STDCALL bind_err = sqlite3_bind_zeroblob64(stmt, index, sqlite3_uint64(column_value_pair.second.bytes));
+            return bind_err;
+        }
+        
         SQLITE_API int SQLITE_STDCALL 
         static bind_value(sqlite3_stmt *stmt, const std::pair<std::string, const sqlite3_value *> &column_value_pair) {
             std::string parameter_name("$");
@@ -308,6 +946,12 @@ namespace sqlite_tool {
             return bind_err;
         }
         
+        SQLITE_API int SQLITE_STDCALL 
+        static bind_value(sqlite3_stmt *stmt, const std::pair<size_t, zero_blob> &column_value_pair) {
+            SQLITE_API int SQLITE_STDCALL bind_err = sqlite3_bind_zeroblob64(stmt, int(column_value_pair.first) + 1, sqlite3_uint64(column_value_pair.second.bytes));
+            return bind_err;
+        }
+        
         SQLITE_API int SQLITE_STDCALL 
         static bind_value(sqlite3_stmt *stmt, const std::pair<size_t, const sqlite3_value *> &column_value_pair) {
             SQLITE_API int SQLITE_STDCALL bind_err = sqlite3_bind_value(stmt, int(column_value_pair.first) + 1, column_value_pair.second);
@@ -323,415 +967,5718 @@ namespace sqlite_tool {
             }
             return bind_value(stmt, std::forward<ST>(second), std::forward<RT>(rest)...);
         }
+        
+        /**
+         *bind with parameter index (start from 1) and value, without building a pair
+         */
+        SQLITE_API int SQLITE_STDCALL
+        static bind_parameter(sqlite3_stmt *stmt, int index, const integer &value) {
+            return sqlite3_bind_int64(stmt, index, value);
+        }
+        
+        SQLITE_API int SQLITE_STDCALL
+        static bind_parameter(sqlite3_stmt *stmt, int index, const real &value) {
+            return sqlite3_bind_double(stmt, index, value);
+        }
+        
+        SQLITE_API int SQLITE_STDCALL
+        static bind_parameter(sqlite3_stmt *stmt, int index, const char_string &value) {
+            return sqlite3_bind_text(stmt, index, value.c_str(), int(value.size()), SQLITE_TRANSIENT);
+        }
+        
+        SQLITE_API int SQLITE_STDCALL
+        static bind_parameter(sqlite3_stmt *stmt, int index, const data_string &value) {
+            return sqlite3_bind_blob(stmt, index, value.data(), int(value.size()), SQLITE_TRANSIENT);
+        }
     };
-
-    using Col_Nms_Type = std::vector<std::string>;
-    using Col_Tps_Type = std::vector<std::string>;
-    using Db_Row_Type = std::vector<sqlite3_row::column_info>;
     
-	template<typename T>
-	void
-	make_column_constraint(Col_Tps_Type& column_constraints, Db_Row_Type& db_row, size_t& column_count, size_t& db_row_size) {
-		throw;
-	}
-    //integer
-    template<>
-    void
-	make_column_constraint<typename sqlite_tool::integer>(Col_Tps_Type& column_constraints, Db_Row_Type& db_row, size_t& column_count, size_t& db_row_size) {
-		column_constraints.emplace_back(std::string("INTEGER DEFAULT 0"));
-		const std::type_info& col_tp = typeid(sqlite_tool::integer);
-		auto&& col_tuple = sqlite3_row::column_info(db_row_size, sizeof(sqlite_tool::integer), column_count, col_tp);
-		db_row.emplace_back(std::move(col_tuple));
-		db_row_size += sizeof(sqlite_tool::integer);
-		column_count++;
-	}
-    //real
-    template<>
-    void
-	make_column_constraint<typename sqlite_tool::real>(Col_Tps_Type& column_constraints, Db_Row_Type& db_row, size_t& column_count, size_t& db_row_size) {
-		column_constraints.emplace_back(std::string("REAL DEFAULT 0.0"));
-		const std::type_info& col_tp = typeid(sqlite_tool::real);
-		auto&& col_tuple = sqlite3_row::column_info(db_row_size, sizeof(sqlite_tool::real), column_count, col_tp);
-		db_row.emplace_back(std::move(col_tuple));
-		db_row_size += sizeof(sqlite_tool::real);
-		column_count++;
-	}
-    //char_string
-    template<>
-    void
-	make_column_constraint<typename sqlite_tool::char_string>(Col_Tps_Type& column_constraints, Db_Row_Type& db_row, size_t& column_count, size_t& db_row_size) {
-		column_constraints.emplace_back(std::string("TEXT DEFAULT \"\""));
-		const std::type_info& col_tp = typeid(sqlite_tool::char_string);
-		auto&& col_tuple = sqlite3_row::column_info(db_row_size, sizeof(sqlite_tool::char_string), column_count, col_tp);
-		db_row.emplace_back(std::move(col_tuple));
-		db_row_size += sizeof(sqlite_tool::char_string);
-		column_count++;
-	}
-    //data_string
-    template<>
-    void
-	make_column_constraint<typename sqlite_tool::data_string>(Col_Tps_Type& column_constraints, Db_Row_Type& db_row, size_t& column_count, size_t& db_row_size) {
-		column_constraints.emplace_back(std::string("BLOB NOT NULL"));
-		const std::type_info& col_tp = typeid(sqlite_tool::data_string);
-		auto&& col_tuple = sqlite3_row::column_info(db_row_size, sizeof(sqlite_tool::data_string), column_count, col_tp);
-		db_row.emplace_back(std::move(col_tuple));
-		db_row_size += sizeof(sqlite_tool::data_string);
-		column_count++;
-	}
-    
-    template<typename...COLUMN_TYPE>
-    class sqlite3_delegate {        
+    class tuple_utility {
     private:
-        template <typename...T>
-        using tp_type = std::tuple<T...>;
-        typedef tp_type<COLUMN_TYPE...> full_tuple_type;
+        template<size_t index, size_t count>
+        struct tuple_walker {
+            template<typename TUPLE>
+            SQLITE_API int SQLITE_STDCALL
+            static bind(sqlite3_stmt *stmt, const TUPLE &row, int first_parameter) {
+                SQLITE_API int SQLITE_STDCALL bind_err = bind_utility::bind_parameter(stmt, first_parameter + int(index), std::get<index>(row));
+                if (bind_err != SQLITE_OK) {
+                    return bind_err;
+                }
+                return tuple_walker<index + 1, count>::bind(stmt, row, first_parameter);
+            }
+            
+            template<typename TUPLE>
+            void
+            static get(sqlite3_stmt *stmt, TUPLE &row, size_t first_column) {
+                stmt_utility::stmt_get_column(stmt, first_column + index, std::get<index>(row));
+                tuple_walker<index + 1, count>::get(stmt, row, first_column);
+            }
+            
+            template<typename TUPLE>
+            size_t
+            static bytes(const TUPLE &row) {
+                return value_bytes(std::get<index>(row)) + tuple_walker<index + 1, count>::bytes(row);
+            }
+        };
         
-        /**
-         *member variables
-         */
-        sqlite_tool::Col_Nms_Type columns;
-        sqlite_tool::Col_Tps_Type column_constraints;
-        std::string db_file;
-        std::string table;
-        struct sqlite3 *sqdb = nullptr;
-        size_t db_row_size = 0;
-        size_t column_count = 0;
-        sqlite_tool::Db_Row_Type db_row;
+        template<size_t count>
+        struct tuple_walker<count, count> {
+            template<typename TUPLE>
+            SQLITE_API int SQLITE_STDCALL
+            static bind(sqlite3_stmt *, const TUPLE &, int) {
+                return SQLITE_OK;
+            }
+            
+            template<typename TUPLE>
+            void
+            static get(sqlite3_stmt *, TUPLE &, size_t) {
+                
+            }
+            
+            template<typename TUPLE>
+            size_t
+            static bytes(const TUPLE &) {
+                return 0;
+            }
+        };
         
-        std::string execute_conditions;
-    private:
-        void 
-        push_col_name(std::vector<std::string> &columns, std::string &&column) {
-            columns.push_back(column);
-        }
+        template<size_t...index>
+        struct index_list {
+            
+        };
         
-        template<typename FT, typename ST, typename...RT>
-        void 
-        push_col_name(std::vector<std::string> &columns, FT &&first, ST &&second, RT &&...rest) {
-            push_col_name(columns, std::forward<FT>(first));
-            push_col_name(columns, std::forward<ST>(second), std::forward<RT>(rest)...);
-        }
+        template<size_t count, size_t...index>
+        struct make_index_list : make_index_list<count - 1, count - 1, index...> {
+            
+        };
         
-        template<typename T>
-        void
-        init_column_constraints() {
-			make_column_constraint<T>(column_constraints, db_row, column_count, db_row_size);
-        }
+        template<size_t...index>
+        struct make_index_list<0, index...> {
+            typedef index_list<index...> type;
+        };
         
-        template<typename T1, typename T2, typename...Tn>
+        template<typename FUNC, typename TUPLE, size_t...index>
         void
-        init_column_constraints() {
-            init_column_constraints<T1>();
-            init_column_constraints<T2, Tn...>();
+        static apply(FUNC &&func, TUPLE &row, index_list<index...>) {
+            func(std::get<index>(row)...);
         }
-        
     public:
-        
-        sqlite3_delegate() {
-            init_column_constraints<COLUMN_TYPE...>();
+        size_t
+        static value_bytes(const integer &) {
+            return sizeof(integer);
         }
         
-        ~sqlite3_delegate() {
-            if (sqdb) {
-                sqlite3_close(sqdb);
-                sqdb = nullptr;
-            }
+        size_t
+        static value_bytes(const real &) {
+            return sizeof(real);
         }
         
-        void set_db_file_path(std::string db) {
-            db_file = std::move(db);
+        size_t
+        static value_bytes(const char_string &value) {
+            return value.size();
         }
         
-        void set_table_name(std::string table) {
-            this->table = std::move(table);
+        size_t
+        static value_bytes(const data_string &value) {
+            return value.size();
         }
         
+        /**
+         *bind every tuple element in order, the first element goes to parameter first_parameter
+         */
         template<typename...T>
-        void
-        set_column_names(T...t) {
-            if (sizeof...(COLUMN_TYPE) != sizeof...(T)) {
-                throw;
-            }
-            columns.clear();
-            push_col_name(columns, std::forward<T>(t)...);
+        SQLITE_API int SQLITE_STDCALL
+        static bind_row(sqlite3_stmt *stmt, const std::tuple<T...> &row, int first_parameter = 1) {
+            return tuple_walker<0, sizeof...(T)>::bind(stmt, row, first_parameter);
         }
-
-    private:
+        
+        /**
+         *read result columns first_column, first_column + 1, ... of the current step into the tuple elements in order
+         */
+        template<typename...T>
         void
-        push_column_constraint(std::string constraint) {
-            column_constraints.emplace_back(constraint);
+        static get_row(sqlite3_stmt *stmt, std::tuple<T...> &row, size_t first_column = 0) {
+            tuple_walker<0, sizeof...(T)>::get(stmt, row, first_column);
         }
-
-        template<typename T0, typename T1, typename...T>
-        void 
-        push_column_constraint(T0 t0, T1 t1, T...t) {
-            push_column_constraint(std::forward<T0>(t0));
-            push_column_constraint(std::forward<T1>(t1), std::forward<T>(t)...);
-        }
-    public:
+        
+        /**
+         *payload size of a row, used to size write batches
+         */
         template<typename...T>
-        void
-        set_column_constraints(T...t) {
-            if (sizeof...(COLUMN_TYPE) != sizeof...(T)) {
-                throw;
-            }
-            column_constraints.clear();
-            push_column_constraint(std::forward<T>(t)...);
+        size_t
+        static row_bytes(const std::tuple<T...> &row) {
+            return tuple_walker<0, sizeof...(T)>::bytes(row);
         }
         
-        template<std::size_t index>
+        /**
+         *func(std::get<0>(row), std::get<1>(row), ...)
+         */
+        template<typename FUNC, typename...T>
         void
-        add_column_constraint(std::string constraint) {
-//            std::swap(column_constraints.at(index), constraint);
-            column_constraints.at(index).append(" ");
-            column_constraints.at(index).append(constraint);
-        }
-
-        template<std::size_t index>
-        void 
-        set_column_constraint(std::string constraint) {
-            column_constraints.at(index) = constraint;
+        static apply(FUNC &&func, std::tuple<T...> &row) {
+            apply(std::forward<FUNC>(func), row, typename make_index_list<sizeof...(T)>::type());
         }
-
-        SQLITE_API int SQLITE_STDCALL 
-        open_db() {
-            //return sqlite3_open_v2(db_file.c_str(), &sqdb, SQLITE_OPEN_READWRITE, NULL);
-			return sqlite3_open(db_file.c_str(), &sqdb);
+    };
+    
+    /**
+     *struct-of-arrays result: one contiguous vector per selected column plus a null bitmap per column,
+     *bit (row % 64) of word (row / 64) is set when that value was NULL (the vector then holds 0 or empty)
+     */
+    template<typename...T>
+    class columnar_result {
+    public:
+        static const size_t column_count = sizeof...(T);
+        typedef std::tuple<std::vector<T>...> columns_type;
+    private:
+        columns_type values;
+        std::array<std::vector<uint64_t>, sizeof...(T)> nulls;
+        size_t row_count = 0;
+        
+        /**
+         *NULL converts to 0 or empty, so only those values need the extra sqlite3_column_type call
+         */
+        template<typename V>
+        static bool
+        may_be_null(const V &value) {
+            return value == V();
         }
         
-        SQLITE_API int SQLITE_STDCALL
-        create_table_if_not_exists() {
-			auto err = SQLXX_FILE_ACCESS(db_file.c_str(), 00);
-            if (err == SQLXX_FILE_ENOENT) {
-                SQLXX_FILE_CREATE(db_file.c_str(), "a");
+        template<size_t index, size_t count>
+        struct column_walker {
+            static void
+            reserve(columnar_result &result, size_t rows) {
+                std::get<index>(result.values).reserve(rows);
+                result.nulls[index].reserve((rows + 63) / 64);
+                column_walker<index + 1, count>::reserve(result, rows);
             }
             
-            std::string sqlcmd("CREATE TABLE IF NOT EXISTS ");
-            sqlcmd.append(table);
-            sqlcmd.append("(");
-            for (size_t index = 0; index < columns.size(); index++) {
-                const std::string &name = columns.at(index);
-                const std::string &type = column_constraints.at(index);
-                sqlcmd.append(name);
-                sqlcmd.append(" ");
-                sqlcmd.append(type);
-                if (name != columns.back()) {
-                    sqlcmd.append(",");
+            static void
+            append(columnar_result &result, sqlite3_stmt *stmt, size_t first_column) {
+                typedef typename std::tuple_element<index, std::tuple<T...>>::type value_type;
+                std::vector<value_type> &column = std::get<index>(result.values);
+                column.emplace_back();
+                stmt_utility::stmt_get_column(stmt, first_column + index, column.back());
+                if (may_be_null(column.back()) && sqlite3_column_type(stmt, int(first_column + index)) == SQLITE_NULL) {
+                    result.nulls[index].back() |= uint64_t(1) << (result.row_count % 64);
                 }
+                column_walker<index + 1, count>::append(result, stmt, first_column);
             }
-            sqlcmd.append(")");
             
-            if (sqdb == nullptr) {
-                SQLITE_API int SQLITE_STDCALL open_err = open_db();
-                if (open_err != SQLITE_OK) {
-                    return open_err;
-                }
+            static void
+            clear(columnar_result &result) {
+                std::get<index>(result.values).clear();
+                result.nulls[index].clear();
+                column_walker<index + 1, count>::clear(result);
             }
-
-            sqlite3_stmt *stmt = nullptr;
-            SQLITE_API int SQLITE_STDCALL prep_err = sqlite3_prepare_v2(sqdb, sqlcmd.c_str(), int(-1), &stmt, NULL);
-            if (prep_err != SQLITE_OK) {
-                return prep_err;
+        };
+        
+        template<size_t count>
+        struct column_walker<count, count> {
+            static void
+            reserve(columnar_result &, size_t) {
+                
             }
             
-            SQLITE_API int SQLITE_STDCALL step_err = sqlite3_step(stmt);
-            sqlite3_finalize(stmt);
-            if (step_err != SQLITE_DONE) {
-                return step_err;
+            static void
+            append(columnar_result &, sqlite3_stmt *, size_t) {
+                
             }
             
-            return SQLITE_OK;
+            static void
+            clear(columnar_result &) {
+                
+            }
+        };
+    public:
+        size_t
+        size() const {
+            return row_count;
         }
         
-    private:
-        template<typename VALUE>
-        void
-        insert_command_prepare_name(std::string &sqlcmd, const std::pair<std::string, VALUE> &column_value_pair) {
-            sqlcmd.append(column_value_pair.first);
+        bool
+        empty() const {
+            return row_count == 0;
         }
         
-        template<typename VALUE>
-        void
-        insert_command_prepare_name(std::string &sqlcmd, const std::pair<size_t, VALUE> &column_value_pair) {
-            const std::string &column = columns.at(column_value_pair.first);
-            sqlcmd.append(column);
+        template<size_t index>
+        const typename std::tuple_element<index, columns_type>::type &
+        column() const {
+            return std::get<index>(values);
         }
         
-        template<typename FT, typename ST, typename...RT>
-        void
-        insert_command_prepare_name(std::string &sqlcmd, FT &&first, ST &&second, RT &&...rest) {
-            insert_command_prepare_name(sqlcmd, std::forward<FT>(first));
-            sqlcmd.append(",");
-            insert_command_prepare_name(sqlcmd, std::forward<ST>(second), std::forward<RT>(rest)...);
+        /**
+         *64 rows per word, a set bit marks a NULL value
+         */
+        const std::vector<uint64_t> &
+        null_bitmap(size_t index) const {
+            return nulls.at(index);
         }
         
-        template<typename T>
-        void
-        insert_command_prepare_value(std::string &sqlcmd, const std::pair<std::string, T> &column_value_pair) {
-            sqlcmd.append("$");
-            sqlcmd.append(column_value_pair.first);
+        bool
+        is_null(size_t index, size_t row) const {
+            return (nulls.at(index)[row / 64] >> (row % 64)) & 1;
         }
         
-        template<typename VALUE>
         void
-        insert_command_prepare_value(std::string &sqlcmd, const std::pair<size_t, VALUE> &column_value_pair) {
-            sqlcmd.append("?");
+        reserve(size_t rows) {
+            column_walker<0, sizeof...(T)>::reserve(*this, rows);
         }
         
-        template<typename FT, typename ST, typename...RT>
         void
-        insert_command_prepare_value(std::string &sqlcmd, FT &&first, ST &&second, RT &&...rest) {
-            insert_command_prepare_value(sqlcmd, std::forward<FT>(first));
-            sqlcmd.append(",");
-            insert_command_prepare_value(sqlcmd, std::forward<ST>(second), std::forward<RT>(rest)...);
-        }
-        
-    private:
-        template<typename T>
-        std::pair<std::string, T>
-        bind_column_index_transfer_to_name(const std::pair<size_t, T> &pair) {
-            return std::make_pair(columns.at(pair.first), pair.second);
-        }
-        
-        template<typename T>
-        std::pair<std::string, T>
-        bind_column_index_transfer_to_name(const std::pair<std::string, T> &pair) {
-            return pair;
+        clear() {
+            column_walker<0, sizeof...(T)>::clear(*this);
+            row_count = 0;
         }
         
-        template<typename T>
-        std::pair<size_t, T>
-        bind_column_index_transfer(const std::pair<size_t, T> &pair, size_t &index) {
-            return std::make_pair(index++, pair.second);
-        }
-        
-        template<typename T>
-        std::pair<size_t, T>
-        bind_column_index_transfer(const std::pair<std::string, T> &pair, size_t &index) {
-            return std::make_pair(index++, pair.second);
+        /**
+         *result columns first_column, first_column + 1, ... of the current step become one more row
+         */
+        void
+        append(sqlite3_stmt *stmt, size_t first_column = 0) {
+            if (row_count % 64 == 0) {
+                for (std::vector<uint64_t> &bitmap : nulls) {
+                    bitmap.push_back(0);
+                }
+            }
+            column_walker<0, sizeof...(T)>::append(*this, stmt, first_column);
+            row_count++;
         }
-
+    };
+    
+    /**
+     *bulk writes are committed in chunks, a chunk ends when either limit is reached (0 means no limit)
+     */
+    struct batch_options {
+        size_t max_rows = 10000;
+        size_t max_bytes = 0;
+    };
+
+    enum class import_format {
+        csv,
+        binary
+    };
+    
+    /**
+     *csv: one record per line with the fields in column order, RFC 4180 quoting, BLOB fields
+     *written in hex and empty INTEGER/REAL fields read as 0;
+     *binary: each record is a uint32 payload length followed by every column in order,
+     *INTEGER and REAL as 8 little-endian bytes, TEXT and BLOB as a uint32 length and the bytes
+     */
+    struct import_options {
+        import_format format = import_format::csv;
+        char delimiter = ',';
+        /**
+         *skip the first csv record
+         */
+        bool header = false;
+        /**
+         *bytes per read from the file
+         */
+        size_t block_bytes = 1024 * 1024;
+        /**
+         *rows the parser thread hands to the inserting thread at a time, and how many such batches may wait
+         */
+        size_t rows_per_batch = 4096;
+        size_t queued_batches = 4;
+        batch_options commit = batch_options();
+        /**
+         *rejected rows beyond this are counted but not described
+         */
+        size_t max_rejects_kept = 100;
+        /**
+         *binary records announcing a longer payload are skipped and rejected without being loaded
+         */
+        size_t max_record_bytes = 64 * 1024 * 1024;
+    };
+    
+    /**
+     *position is the line a csv record starts on, or the 1-based record number in a binary file
+     */
+    struct rejected_row {
+        size_t position = 0;
+        std::string reason;
+    };
+    
+    struct import_report {
+        size_t records = 0;
+        size_t imported = 0;
+        size_t rejected = 0;
+        size_t bytes = 0;
+        uint64_t elapsed_ns = 0;
+        std::vector<rejected_row> rejects;
+        
+        double
+        rows_per_second() const {
+            return elapsed_ns == 0 ? 0.0 : double(imported) * 1e9 / double(elapsed_ns);
+        }
+        
+        double
+        bytes_per_second() const {
+            return elapsed_ns == 0 ? 0.0 : double(bytes) * 1e9 / double(elapsed_ns);
+        }
+    };
+    
+    /**
+     *reads a file in blocks of a fixed size, one byte or a run of bytes at a time
+     */
+    class block_reader {
+    private:
+        FILE *file = nullptr;
+        std::vector<char> block;
+        size_t position = 0;
+        size_t length = 0;
+        size_t consumed = 0;
+        bool failed = false;
+        
+        bool
+        fill() {
+            if (file == nullptr) {
+                return false;
+            }
+            consumed += length;
+            position = 0;
+            length = fread(block.data(), 1, block.size(), file);
+            if (length == 0 && ferror(file)) {
+                failed = true;
+            }
+            return length != 0;
+        }
+    public:
+        block_reader(const std::string &path, size_t block_bytes) : block(block_bytes == 0 ? 1 : block_bytes) {
+            file = fopen(path.c_str(), "rb");
+        }
+        
+        ~block_reader() {
+            if (file != nullptr) {
+                fclose(file);
+            }
+        }
+        
+        block_reader(const block_reader &) = delete;
+        block_reader &operator=(const block_reader &) = delete;
+        
+        bool
+        is_open() const {
+            return file != nullptr;
+        }
+        
+        bool
+        error() const {
+            return failed;
+        }
+        
+        size_t
+        bytes_read() const {
+            return consumed + position;
+        }
+        
+        int
+        get() {
+            if (position == length && !fill()) {
+                return EOF;
+            }
+            return static_cast<unsigned char>(block[position++]);
+        }
+        
+        int
+        peek() {
+            if (position == length && !fill()) {
+                return EOF;
+            }
+            return static_cast<unsigned char>(block[position]);
+        }
+        
+        /**
+         *false when fewer than size bytes are left
+         */
+        bool
+        read(void *target, size_t size) {
+            char *out = static_cast<char *>(target);
+            while (size != 0) {
+                if (position == length && !fill()) {
+                    return false;
+                }
+                size_t count = std::min(size, length - position);
+                memcpy(out, block.data() + position, count);
+                position += count;
+                out += count;
+                size -= count;
+            }
+            return true;
+        }
+        
+        /**
+         *read past size bytes without keeping them, false when fewer are left
+         */
+        bool
+        skip(size_t size) {
+            while (size != 0) {
+                if (position == length && !fill()) {
+                    return false;
+                }
+                size_t count = std::min(size, length - position);
+                position += count;
+                size -= count;
+            }
+            return true;
+        }
+    };
+    
+    class import_utility {
+    private:
+        template<size_t index, size_t count>
+        struct field_walker {
+            template<typename TUPLE>
+            static bool
+            parse_text(const std::vector<std::string> &fields, TUPLE &row, std::string &reason) {
+                if (!parse_field(fields[index], std::get<index>(row))) {
+                    reason = "field " + std::to_string(index) + " is not a valid " + type_name(std::get<index>(row));
+                    return false;
+                }
+                return field_walker<index + 1, count>::parse_text(fields, row, reason);
+            }
+            
+            template<typename TUPLE>
+            static bool
+            parse_binary(const any_mem_t *&cursor, const any_mem_t *end, TUPLE &row, std::string &reason) {
+                if (!read_field(cursor, end, std::get<index>(row))) {
+                    reason = "record ends inside field " + std::to_string(index);
+                    return false;
+                }
+                return field_walker<index + 1, count>::parse_binary(cursor, end, row, reason);
+            }
+        };
+        
+        template<size_t count>
+        struct field_walker<count, count> {
+            template<typename TUPLE>
+            static bool
+            parse_text(const std::vector<std::string> &, TUPLE &, std::string &) {
+                return true;
+            }
+            
+            template<typename TUPLE>
+            static bool
+            parse_binary(const any_mem_t *&, const any_mem_t *, TUPLE &, std::string &) {
+                return true;
+            }
+        };
+        
+        static const char *type_name(const integer &) { return "INTEGER"; }
+        static const char *type_name(const real &) { return "REAL"; }
+        static const char *type_name(const char_string &) { return "TEXT"; }
+        static const char *type_name(const data_string &) { return "BLOB"; }
+        
+        static int
+        hex_digit(char c) {
+            if (c >= '0' && c <= '9') {
+                return c - '0';
+            }
+            if (c >= 'a' && c <= 'f') {
+                return c - 'a' + 10;
+            }
+            if (c >= 'A' && c <= 'F') {
+                return c - 'A' + 10;
+            }
+            return -1;
+        }
+        
+        static uint64_t
+        little_endian(const any_mem_t *bytes, size_t size) {
+            uint64_t value = 0;
+            for (size_t index = size; index != 0; index--) {
+                value = (value << 8) | bytes[index - 1];
+            }
+            return value;
+        }
+    public:
+        static bool
+        parse_field(const std::string &field, integer &value) {
+            if (field.empty()) {
+                value = 0;
+                return true;
+            }
+            char *end = nullptr;
+            errno = 0;
+            value = strtoll(field.c_str(), &end, 10);
+            return errno == 0 && end == field.c_str() + field.size();
+        }
+        
+        static bool
+        parse_field(const std::string &field, real &value) {
+            if (field.empty()) {
+                value = 0.0;
+                return true;
+            }
+            char *end = nullptr;
+            value = strtod(field.c_str(), &end);
+            return end == field.c_str() + field.size();
+        }
+        
+        static bool
+        parse_field(const std::string &field, char_string &value) {
+            value = field;
+            return true;
+        }
+        
+        static bool
+        parse_field(const std::string &field, data_string &value) {
+            if (field.size() % 2 != 0) {
+                return false;
+            }
+            value.resize(field.size() / 2);
+            for (size_t index = 0; index < value.size(); index++) {
+                int high = hex_digit(field[index * 2]);
+                int low = hex_digit(field[index * 2 + 1]);
+                if (high < 0 || low < 0) {
+                    return false;
+                }
+                value[index] = any_mem_t(high << 4 | low);
+            }
+            return true;
+        }
+        
+        static bool
+        read_field(const any_mem_t *&cursor, const any_mem_t *end, integer &value) {
+            if (size_t(end - cursor) < 8) {
+                return false;
+            }
+            value = integer(little_endian(cursor, 8));
+            cursor += 8;
+            return true;
+        }
+        
+        static bool
+        read_field(const any_mem_t *&cursor, const any_mem_t *end, real &value) {
+            if (size_t(end - cursor) < 8) {
+                return false;
+            }
+            uint64_t bits = little_endian(cursor, 8);
+            memcpy(&value, &bits, sizeof(value));
+            cursor += 8;
+            return true;
+        }
+        
+        static bool
+        read_field(const any_mem_t *&cursor, const any_mem_t *end, char_string &value) {
+            if (size_t(end - cursor) < 4 || size_t(end - cursor) - 4 < little_endian(cursor, 4)) {
+                return false;
+            }
+            size_t size = size_t(little_endian(cursor, 4));
+            value.assign(reinterpret_cast<const char *>(cursor + 4), size);
+            cursor += 4 + size;
+            return true;
+        }
+        
+        static bool
+        read_field(const any_mem_t *&cursor, const any_mem_t *end, data_string &value) {
+            if (size_t(end - cursor) < 4 || size_t(end - cursor) - 4 < little_endian(cursor, 4)) {
+                return false;
+            }
+            size_t size = size_t(little_endian(cursor, 4));
+            value.assign(cursor + 4, size);
+            cursor += 4 + size;
+            return true;
+        }
+        
+        /**
+         *fields[i] into element i, reason names the first field that does not convert
+         */
+        template<typename...T>
+        static bool
+        fields_to_row(const std::vector<std::string> &fields, size_t field_count, std::tuple<T...> &row, std::string &reason) {
+            if (field_count != sizeof...(T)) {
+                reason = "expected " + std::to_string(sizeof...(T)) + " fields, found " + std::to_string(field_count);
+                return false;
+            }
+            return field_walker<0, sizeof...(T)>::parse_text(fields, row, reason);
+        }
+        
+        /**
+         *one binary record payload (without its length prefix) into a row
+         */
+        template<typename...T>
+        static bool
+        record_to_row(const any_mem_t *payload, size_t size, std::tuple<T...> &row, std::string &reason) {
+            const any_mem_t *cursor = payload;
+            if (!field_walker<0, sizeof...(T)>::parse_binary(cursor, payload + size, row, reason)) {
+                return false;
+            }
+            if (cursor != payload + size) {
+                reason = std::to_string(size_t(payload + size - cursor)) + " bytes left after the last field";
+                return false;
+            }
+            return true;
+        }
+        
+        /**
+         *next csv record into fields[0, field_count), blank lines are skipped;
+         *false at the end of the input, malformed is set for a quote left open at the end of the file
+         */
+        static bool
+        next_csv_record(block_reader &in, char delimiter, std::vector<std::string> &fields, size_t &field_count, size_t &line, size_t &record_line, bool &malformed) {
+            malformed = false;
+            for (;;) {
+                int c = in.get();
+                if (c == EOF) {
+                    return false;
+                }
+                record_line = line;
+                field_count = 0;
+                auto next_field = [&]() -> std::string & {
+                    if (field_count == fields.size()) {
+                        fields.emplace_back();
+                    }
+                    fields[field_count].clear();
+                    return fields[field_count++];
+                };
+                std::string *field = &next_field();
+                bool quoted = false;
+                bool was_quoted = false;
+                bool field_start = true;
+                for (;; c = in.get()) {
+                    if (quoted) {
+                        if (c == EOF) {
+                            malformed = true;
+                            break;
+                        }
+                        if (c == '"') {
+                            if (in.peek() == '"') {
+                                in.get();
+                                field->push_back('"');
+                            }
+                            else {
+                                quoted = false;
+                            }
+                            continue;
+                        }
+                        if (c == '\n') {
+                            line++;
+                        }
+                        field->push_back(char(c));
+                        continue;
+                    }
+                    if (c == EOF) {
+                        break;
+                    }
+                    if (c == '\n') {
+                        line++;
+                        break;
+                    }
+                    if (c == '\r' && in.peek() == '\n') {
+                        continue;
+                    }
+                    if (c == delimiter) {
+                        field = &next_field();
+                        field_start = true;
+                        continue;
+                    }
+                    if (c == '"' && field_start) {
+                        quoted = true;
+                        was_quoted = true;
+                        field_start = false;
+                        continue;
+                    }
+                    field_start = false;
+                    field->push_back(char(c));
+                }
+                if (field_count == 1 && fields[0].empty() && !was_quoted) {
+                    if (c == EOF) {
+                        return false;
+                    }
+                    continue;
+                }
+                return true;
+            }
+        }
+        
+        /**
+         *next binary record payload; false at the end of the input, truncated is set when the file ends inside a record;
+         *a length prefix over max_bytes is never trusted with an allocation, the payload is skipped and oversized set
+         */
+        static bool
+        next_binary_record(block_reader &in, std::vector<any_mem_t> &payload, size_t max_bytes, bool &truncated, bool &oversized) {
+            truncated = false;
+            oversized = false;
+            any_mem_t prefix[4];
+            if (in.peek() == EOF) {
+                return false;
+            }
+            if (!in.read(prefix, sizeof(prefix))) {
+                truncated = true;
+                return false;
+            }
+            size_t payload_bytes = size_t(little_endian(prefix, 4));
+            if (payload_bytes > max_bytes) {
+                payload.clear();
+                if (!in.skip(payload_bytes)) {
+                    truncated = true;
+                    return false;
+                }
+                oversized = true;
+                return true;
+            }
+            payload.resize(payload_bytes);
+            if (!payload.empty() && !in.read(payload.data(), payload.size())) {
+                truncated = true;
+                return false;
+            }
+            return true;
+        }
+    };
+
+    /**
+     *prepared statements of one connection, keyed by sql text;
+     *acquire checks a statement out of the cache (or prepares a new one),
+     *release resets it and puts it back as the most recently used entry
+     */
+    class stmt_cache {
+    private:
+        typedef std::pair<std::string, sqlite3_stmt *> cache_entry;
+        
+        std::list<cache_entry> entries;
+        std::unordered_map<std::string, std::list<cache_entry>::iterator> entry_index;
+        size_t capacity = 32;
+        
+        void
+        evict_over_capacity() {
+            while (entries.size() > capacity) {
+                cache_entry &last = entries.back();
+                sqlite3_finalize(last.second);
+                entry_index.erase(last.first);
+                entries.pop_back();
+            }
+        }
+    public:
+        stmt_cache() {
+            
+        }
+        
+        ~stmt_cache() {
+            clear();
+        }
+        
+        stmt_cache(const stmt_cache &) = delete;
+        stmt_cache &operator=(const stmt_cache &) = delete;
+        
+        void
+        set_capacity(size_t size) {
+            capacity = size;
+            evict_over_capacity();
+        }
+        
+        size_t
+        get_capacity() const {
+            return capacity;
+        }
+        
+        size_t
+        size() const {
+            return entries.size();
+        }
+        
+        /**
+         *the statement is owned by the caller until release;
+         *a statement already checked out is never handed out twice, a second one is prepared instead
+         */
+        SQLITE_API int SQLITE_STDCALL
+        acquire(sqlite3 *db, const std::string &sqlcmd, sqlite3_stmt **stmt, bool *prepared = nullptr) {
+            auto found = entry_index.find(sqlcmd);
+            if (found != entry_index.end()) {
+                *stmt = found->second->second;
+                entries.erase(found->second);
+                entry_index.erase(found);
+                return SQLITE_OK;
+            }
+            if (prepared != nullptr) {
+                *prepared = true;
+            }
+#if SQLITE_VERSION_NUMBER >= 3020000
+            return sqlite3_prepare_v3(db, sqlcmd.c_str(), int(sqlcmd.size()), SQLITE_PREPARE_PERSISTENT, stmt, NULL);
+#else
+            return sqlite3_prepare_v2(db, sqlcmd.c_str(), int(sqlcmd.size()), stmt, NULL);
+#endif
+        }
+        
+        void
+        release(sqlite3_stmt *stmt) {
+            if (stmt == nullptr) {
+                return;
+            }
+            sqlite3_reset(stmt);
+            sqlite3_clear_bindings(stmt);
+            const char *sql = sqlite3_sql(stmt);
+            if (capacity == 0 || sql == nullptr || entry_index.count(sql) != 0) {
+                sqlite3_finalize(stmt);
+                return;
+            }
+            entries.emplace_front(std::string(sql), stmt);
+            entry_index[entries.front().first] = entries.begin();
+            evict_over_capacity();
+        }
+        
+        /**
+         *must be called before the owning connection is closed
+         */
+        void
+        clear() {
+            for (cache_entry &entry : entries) {
+                sqlite3_finalize(entry.second);
+            }
+            entries.clear();
+            entry_index.clear();
+        }
+    };
+
+    enum class operation_type {
+        put_row,
+        put_rows,
+        get_all,
+        get_column_value,
+        get_column_value_match_conditions,
+        get_column_value_page,
+        get_columnar,
+        aggregate,
+        scan,
+        update_column_value_match_conditions,
+        delete_rows_match_conditions,
+        visit,
+        parallel_scan
+    };
+    
+    const size_t operation_type_count = size_t(operation_type::parallel_scan) + 1;
+    
+    /**
+     *times in nanoseconds; prepare_count counts real prepares, statement cache hits are not prepares;
+     *vm_steps, fullscan_steps and sorts come from sqlite3_stmt_status
+     */
+    struct operation_statistics {
+        size_t calls = 0;
+        size_t prepare_count = 0;
+        uint64_t prepare_ns = 0;
+        uint64_t bind_ns = 0;
+        size_t step_count = 0;
+        uint64_t step_ns = 0;
+        size_t rows = 0;
+        size_t bytes_out = 0;
+        size_t vm_steps = 0;
+        size_t fullscan_steps = 0;
+        size_t sorts = 0;
+        
+        void
+        add(const operation_statistics &other) {
+            calls += other.calls;
+            prepare_count += other.prepare_count;
+            prepare_ns += other.prepare_ns;
+            bind_ns += other.bind_ns;
+            step_count += other.step_count;
+            step_ns += other.step_ns;
+            rows += other.rows;
+            bytes_out += other.bytes_out;
+            vm_steps += other.vm_steps;
+            fullscan_steps += other.fullscan_steps;
+            sorts += other.sorts;
+        }
+    };
+    
+    struct delegate_statistics {
+        std::array<operation_statistics, operation_type_count> operations;
+        
+        const operation_statistics &
+        at(operation_type type) const {
+            return operations.at(size_t(type));
+        }
+    };
+    
+    typedef std::function<void(operation_type, const operation_statistics &)> statistics_callback;
+    
+#if SQLXX_INSTRUMENTATION
+    /**
+     *totals of one delegate, probes of reader threads record concurrently
+     */
+    class statistics_sink {
+    private:
+        std::mutex totals_mutex;
+        delegate_statistics totals;
+        statistics_callback callback;
+    public:
+        void
+        record(operation_type type, const operation_statistics &statistics) {
+            statistics_callback notify;
+            {
+                std::lock_guard<std::mutex> lock(totals_mutex);
+                totals.operations.at(size_t(type)).add(statistics);
+                notify = callback;
+            }
+            if (notify) {
+                notify(type, statistics);
+            }
+        }
+        
+        delegate_statistics
+        snapshot() {
+            std::lock_guard<std::mutex> lock(totals_mutex);
+            return totals;
+        }
+        
+        void
+        reset() {
+            std::lock_guard<std::mutex> lock(totals_mutex);
+            totals = delegate_statistics();
+        }
+        
+        void
+        set_callback(statistics_callback hook) {
+            std::lock_guard<std::mutex> lock(totals_mutex);
+            callback = std::move(hook);
+        }
+    };
+    
+    /**
+     *measures one call of a delegate operation, recorded when it goes out of scope;
+     *start() marks the beginning of the phase that the next prepared/bound/stepped call ends
+     */
+    class operation_probe {
+    private:
+        typedef std::chrono::steady_clock probe_clock;
+        
+        statistics_sink &sink;
+        operation_type type;
+        operation_statistics current;
+        probe_clock::time_point mark;
+        size_t bytes_before;
+        
+        uint64_t
+        elapsed() const {
+            return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(probe_clock::now() - mark).count());
+        }
+    public:
+        operation_probe(statistics_sink &sink, operation_type type) : sink(sink), type(type), bytes_before(stmt_utility::copied_bytes()) {
+            current.calls = 1;
+        }
+        
+        ~operation_probe() {
+            current.bytes_out = stmt_utility::copied_bytes() - bytes_before;
+            sink.record(type, current);
+        }
+        
+        operation_probe(const operation_probe &) = delete;
+        operation_probe &operator=(const operation_probe &) = delete;
+        
+        void
+        start() {
+            mark = probe_clock::now();
+        }
+        
+        void
+        prepared(bool did_prepare) {
+            current.prepare_ns += elapsed();
+            if (did_prepare) {
+                current.prepare_count++;
+            }
+        }
+        
+        void
+        bound() {
+            current.bind_ns += elapsed();
+        }
+        
+        void
+        stepped(int step_err) {
+            current.step_ns += elapsed();
+            current.step_count++;
+            if (step_err == SQLITE_ROW) {
+                current.rows++;
+            }
+        }
+        
+        /**
+         *call before the statement is released, the counters are reset for its next use
+         */
+        void
+        statement(sqlite3_stmt *stmt) {
+            if (stmt == nullptr) {
+                return;
+            }
+            current.vm_steps += size_t(sqlite3_stmt_status(stmt, SQLITE_STMTSTATUS_VM_STEP, 1));
+            current.fullscan_steps += size_t(sqlite3_stmt_status(stmt, SQLITE_STMTSTATUS_FULLSCAN_STEP, 1));
+            current.sorts += size_t(sqlite3_stmt_status(stmt, SQLITE_STMTSTATUS_SORT, 1));
+        }
+    };
+#else
+    class statistics_sink {
+    public:
+        void
+        record(operation_type, const operation_statistics &) {
+            
+        }
+        
+        delegate_statistics
+        snapshot() {
+            return delegate_statistics();
+        }
+        
+        void
+        reset() {
+            
+        }
+        
+        void
+        set_callback(statistics_callback) {
+            
+        }
+    };
+    
+    class operation_probe {
+    public:
+        operation_probe(statistics_sink &, operation_type) {
+            
+        }
+        
+        void
+        start() {
+            
+        }
+        
+        void
+        prepared(bool) {
+            
+        }
+        
+        void
+        bound() {
+            
+        }
+        
+        void
+        stepped(int) {
+            
+        }
+        
+        void
+        statement(sqlite3_stmt *) {
+            
+        }
+    };
+#endif
+    
+    /**
+     *connection settings applied once right after a connection is opened,
+     *values left unset keep SQLite's defaults
+     */
+    struct open_options {
+        enum class journal_mode_t { unset, delete_journal, truncate, persist, memory, wal, off };
+        enum class synchronous_t { unset, off, normal, full, extra };
+        enum class temp_store_t { unset, file, memory };
+        
+        /**
+         *flags for sqlite3_open_v2, 0 opens with sqlite3_open
+         */
+        int flags = 0;
+        journal_mode_t journal_mode = journal_mode_t::unset;
+        synchronous_t synchronous = synchronous_t::unset;
+        /**
+         *PRAGMA cache_size: positive in pages, negative in KiB, 0 unset
+         */
+        integer cache_size = 0;
+        /**
+         *bytes, -1 unset
+         */
+        integer mmap_size = -1;
+        temp_store_t temp_store = temp_store_t::unset;
+        /**
+         *only takes effect before the database is first written, 0 unset
+         */
+        integer page_size = 0;
+        /**
+         *milliseconds, -1 unset
+         */
+        int busy_timeout = -1;
+        
+        /**
+         *large imports: WAL without fsync on commit, big cache, temporaries in memory
+         */
+        static open_options
+        bulk_load() {
+            open_options options;
+            options.journal_mode = journal_mode_t::wal;
+            options.synchronous = synchronous_t::off;
+            options.cache_size = -262144;
+            options.temp_store = temp_store_t::memory;
+            options.busy_timeout = 5000;
+            return options;
+        }
+        
+        /**
+         *query workloads: WAL so readers do not block on the writer, memory mapped reads
+         */
+        static open_options
+        read_heavy() {
+            open_options options;
+            options.journal_mode = journal_mode_t::wal;
+            options.synchronous = synchronous_t::normal;
+            options.cache_size = -65536;
+            options.mmap_size = 268435456;
+            options.temp_store = temp_store_t::memory;
+            options.busy_timeout = 5000;
+            return options;
+        }
+        
+        /**
+         *every commit is synced to disk before it returns
+         */
+        static open_options
+        durable() {
+            open_options options;
+            options.journal_mode = journal_mode_t::wal;
+            options.synchronous = synchronous_t::full;
+            options.busy_timeout = 5000;
+            return options;
+        }
+        
+    private:
+        static const char *
+        journal_mode_name(journal_mode_t mode) {
+            switch (mode) {
+                case journal_mode_t::delete_journal:
+                    return "DELETE";
+                case journal_mode_t::truncate:
+                    return "TRUNCATE";
+                case journal_mode_t::persist:
+                    return "PERSIST";
+                case journal_mode_t::memory:
+                    return "MEMORY";
+                case journal_mode_t::wal:
+                    return "WAL";
+                case journal_mode_t::off:
+                    return "OFF";
+                default:
+                    return nullptr;
+            }
+        }
+        
+        SQLITE_API int SQLITE_STDCALL
+        static pragma(sqlite3 *db, const std::string &sqlcmd) {
+            return sqlite3_exec(db, sqlcmd.c_str(), NULL, NULL, NULL);
+        }
+        
+        SQLITE_API int SQLITE_STDCALL
+        static pragma_value(sqlite3 *db, const char *sqlcmd, std::string &value) {
+            value.clear();
+            return sqlite3_exec(db, sqlcmd, [](void *result, int, char **values, char **) -> int {
+                if (values[0] != nullptr) {
+                    reinterpret_cast<std::string *>(result)->assign(values[0]);
+                }
+                return 0;
+            }, &value, NULL);
+        }
+    public:
+        /**
+         *read_only connections skip the settings that belong to the database file
+         *(page_size, journal_mode, synchronous)
+         */
+        SQLITE_API int SQLITE_STDCALL
+        apply(sqlite3 *db, bool read_only = false) const {
+            SQLITE_API int SQLITE_STDCALL err = SQLITE_OK;
+            if (!read_only && page_size > 0) {
+                err = pragma(db, "PRAGMA page_size=" + std::to_string(page_size));
+                if (err != SQLITE_OK) {
+                    return err;
+                }
+            }
+            const char *journal = journal_mode_name(journal_mode);
+            if (!read_only && journal != nullptr) {
+                err = pragma(db, std::string("PRAGMA journal_mode=") + journal);
+                if (err != SQLITE_OK) {
+                    return err;
+                }
+            }
+            if (!read_only && synchronous != synchronous_t::unset) {
+                err = pragma(db, "PRAGMA synchronous=" + std::to_string(int(synchronous) - 1));
+                if (err != SQLITE_OK) {
+                    return err;
+                }
+            }
+            if (cache_size != 0) {
+                err = pragma(db, "PRAGMA cache_size=" + std::to_string(cache_size));
+                if (err != SQLITE_OK) {
+                    return err;
+                }
+            }
+            if (mmap_size >= 0) {
+                err = pragma(db, "PRAGMA mmap_size=" + std::to_string(mmap_size));
+                if (err != SQLITE_OK) {
+                    return err;
+                }
+            }
+            if (temp_store != temp_store_t::unset) {
+                err = pragma(db, "PRAGMA temp_store=" + std::to_string(int(temp_store)));
+                if (err != SQLITE_OK) {
+                    return err;
+                }
+            }
+            if (busy_timeout >= 0) {
+                err = sqlite3_busy_timeout(db, busy_timeout);
+            }
+            return err;
+        }
+        
+        /**
+         *the values in effect on db, flags are not reported
+         */
+        SQLITE_API int SQLITE_STDCALL
+        static query(sqlite3 *db, open_options &effective) {
+            effective = open_options();
+            std::string value;
+            SQLITE_API int SQLITE_STDCALL err = pragma_value(db, "PRAGMA journal_mode", value);
+            if (err != SQLITE_OK) {
+                return err;
+            }
+            for (int mode = int(journal_mode_t::delete_journal); mode <= int(journal_mode_t::off); mode++) {
+                if (sqlite3_stricmp(value.c_str(), journal_mode_name(journal_mode_t(mode))) == 0) {
+                    effective.journal_mode = journal_mode_t(mode);
+                }
+            }
+            err = pragma_value(db, "PRAGMA synchronous", value);
+            if (err != SQLITE_OK) {
+                return err;
+            }
+            effective.synchronous = synchronous_t(atoi(value.c_str()) + 1);
+            err = pragma_value(db, "PRAGMA cache_size", value);
+            if (err != SQLITE_OK) {
+                return err;
+            }
+            effective.cache_size = strtoll(value.c_str(), nullptr, 10);
+            err = pragma_value(db, "PRAGMA mmap_size", value);
+            if (err != SQLITE_OK) {
+                return err;
+            }
+            effective.mmap_size = value.empty() ? 0 : strtoll(value.c_str(), nullptr, 10);
+            err = pragma_value(db, "PRAGMA temp_store", value);
+            if (err != SQLITE_OK) {
+                return err;
+            }
+            effective.temp_store = temp_store_t(atoi(value.c_str()));
+            err = pragma_value(db, "PRAGMA page_size", value);
+            if (err != SQLITE_OK) {
+                return err;
+            }
+            effective.page_size = strtoll(value.c_str(), nullptr, 10);
+            err = pragma_value(db, "PRAGMA busy_timeout", value);
+            if (err != SQLITE_OK) {
+                return err;
+            }
+            effective.busy_timeout = atoi(value.c_str());
+            return SQLITE_OK;
+        }
+    };
+    
+    /**
+     *read-only connections shared by the query methods of one delegate;
+     *checkout never blocks, when every pooled connection is busy (e.g. a query
+     *issued while iterating a cursor) an overflow connection is opened and
+     *closed again on checkin
+     */
+    class reader_pool {
+    public:
+        struct connection {
+            sqlite3 *db = nullptr;
+            stmt_cache statements;
+            
+            ~connection() {
+                statements.clear();
+                if (db) {
+                    sqlite3_close(db);
+                    db = nullptr;
+                }
+            }
+        };
+    private:
+        std::string db_file;
+        int open_flags = SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX;
+        open_options options;
+        size_t pool_size = 0;
+        std::vector<std::unique_ptr<connection>> idle;
+        std::mutex idle_mutex;
+        
+        SQLITE_API int SQLITE_STDCALL
+        open_connection(std::unique_ptr<connection> &conn) {
+            conn.reset(new connection());
+            SQLITE_API int SQLITE_STDCALL open_err = sqlite3_open_v2(db_file.c_str(), &conn->db, open_flags, NULL);
+            if (open_err == SQLITE_OK) {
+                open_err = options.apply(conn->db, true);
+            }
+            if (open_err != SQLITE_OK) {
+                conn.reset();
+            }
+            return open_err;
+        }
+    public:
+        reader_pool() {
+            
+        }
+        
+        ~reader_pool() {
+            close();
+        }
+        
+        reader_pool(const reader_pool &) = delete;
+        reader_pool &operator=(const reader_pool &) = delete;
+        
+        SQLITE_API int SQLITE_STDCALL
+        open(const std::string &path, size_t count, const open_options &connection_options = open_options()) {
+            close();
+            std::lock_guard<std::mutex> lock(idle_mutex);
+            db_file = path;
+            options = connection_options;
+            for (size_t index = 0; index < count; index++) {
+                std::unique_ptr<connection> conn;
+                SQLITE_API int SQLITE_STDCALL open_err = open_connection(conn);
+                if (open_err != SQLITE_OK) {
+                    idle.clear();
+                    return open_err;
+                }
+                idle.emplace_back(std::move(conn));
+            }
+            pool_size = count;
+            return SQLITE_OK;
+        }
+        
+        /**
+         *connections checked out at this point are closed on checkin instead
+         */
+        void
+        close() {
+            std::lock_guard<std::mutex> lock(idle_mutex);
+            idle.clear();
+            pool_size = 0;
+        }
+        
+        size_t
+        size() const {
+            return pool_size;
+        }
+        
+        SQLITE_API int SQLITE_STDCALL
+        checkout(std::unique_ptr<connection> &conn) {
+            {
+                std::lock_guard<std::mutex> lock(idle_mutex);
+                if (!idle.empty()) {
+                    conn = std::move(idle.back());
+                    idle.pop_back();
+                    return SQLITE_OK;
+                }
+            }
+            return open_connection(conn);
+        }
+        
+        void
+        checkin(std::unique_ptr<connection> &&conn) {
+            std::lock_guard<std::mutex> lock(idle_mutex);
+            if (idle.size() < pool_size) {
+                idle.emplace_back(std::move(conn));
+            }
+            else {
+                conn.reset();
+            }
+        }
+    };
+    
+    /**
+     *connection used by one read: a pooled reader, or the delegate's own connection when no pool is open
+     */
+    class connection_lease {
+    private:
+        reader_pool *pool = nullptr;
+        std::unique_ptr<reader_pool::connection> pooled;
+        sqlite3 *db = nullptr;
+        stmt_cache *cache = nullptr;
+        SQLITE_API int SQLITE_STDCALL open_err = SQLITE_OK;
+        
+        void
+        connection_lease_rv(connection_lease &&obj) {
+            std::swap(pool, obj.pool);
+            std::swap(pooled, obj.pooled);
+            std::swap(db, obj.db);
+            std::swap(cache, obj.cache);
+            std::swap(open_err, obj.open_err);
+        }
+    public:
+        connection_lease() {
+            
+        }
+        
+        connection_lease(sqlite3 *db, stmt_cache *cache, int err) : db(db), cache(cache), open_err(err) {
+            
+        }
+        
+        explicit connection_lease(reader_pool *pool) : pool(pool) {
+            open_err = pool->checkout(pooled);
+            if (open_err == SQLITE_OK) {
+                db = pooled->db;
+                cache = &pooled->statements;
+            }
+        }
+        
+        ~connection_lease() {
+            if (pool != nullptr && pooled) {
+                pool->checkin(std::move(pooled));
+            }
+        }
+        
+        connection_lease(const connection_lease &) = delete;
+        connection_lease(connection_lease &&obj) {
+            connection_lease_rv(std::forward<connection_lease>(obj));
+        }
+        
+        connection_lease &operator=(const connection_lease &) = delete;
+        connection_lease &operator=(connection_lease &&obj) {
+            connection_lease_rv(std::forward<connection_lease>(obj));
+            return *this;
+        }
+        
+        SQLITE_API int SQLITE_STDCALL
+        error() const {
+            return open_err;
+        }
+        
+        sqlite3 *
+        handle() const {
+            return db;
+        }
+        
+        SQLITE_API int SQLITE_STDCALL
+        prepare(const std::string &sqlcmd, sqlite3_stmt **stmt, bool *prepared = nullptr) {
+            if (open_err != SQLITE_OK) {
+                return open_err;
+            }
+            return cache->acquire(db, sqlcmd, stmt, prepared);
+        }
+        
+        void
+        release(sqlite3_stmt *stmt) {
+            cache->release(stmt);
+        }
+    };
+    
+    /**
+     *unbounded multi-producer single-consumer queue (Vyukov): push is wait-free,
+     *pop is done by one consumer thread only and may miss a node whose push is still in progress
+     */
+    template<typename T>
+    class mpsc_queue {
+    private:
+        struct node {
+            std::atomic<node *> next;
+            T value;
+            
+            node() : next(nullptr) {
+                
+            }
+            
+            explicit node(T &&value) : next(nullptr), value(std::move(value)) {
+                
+            }
+        };
+        
+        std::atomic<node *> head;
+        node *tail;
+    public:
+        mpsc_queue() {
+            node *stub = new node();
+            head.store(stub);
+            tail = stub;
+        }
+        
+        ~mpsc_queue() {
+            T value;
+            while (pop(value)) {
+                
+            }
+            delete tail;
+        }
+        
+        mpsc_queue(const mpsc_queue &) = delete;
+        mpsc_queue &operator=(const mpsc_queue &) = delete;
+        
+        void
+        push(T value) {
+            node *item = new node(std::move(value));
+            node *prev = head.exchange(item, std::memory_order_acq_rel);
+            prev->next.store(item, std::memory_order_release);
+        }
+        
+        bool
+        pop(T &value) {
+            node *next = tail->next.load(std::memory_order_acquire);
+            if (next == nullptr) {
+                return false;
+            }
+            value = std::move(next->value);
+            delete tail;
+            tail = next;
+            return true;
+        }
+    };
+    
+    /**
+     *blocking queue of at most capacity items between two threads; close() wakes both sides,
+     *push then fails and pop drains what is left before failing
+     */
+    template<typename T>
+    class bounded_queue {
+    private:
+        std::deque<T> items;
+        size_t capacity;
+        bool closed = false;
+        std::mutex items_mutex;
+        std::condition_variable not_empty;
+        std::condition_variable not_full;
+    public:
+        explicit bounded_queue(size_t capacity) : capacity(capacity == 0 ? 1 : capacity) {
+            
+        }
+        
+        bounded_queue(const bounded_queue &) = delete;
+        bounded_queue &operator=(const bounded_queue &) = delete;
+        
+        bool
+        push(T value) {
+            std::unique_lock<std::mutex> lock(items_mutex);
+            not_full.wait(lock, [this]() {
+                return items.size() < capacity || closed;
+            });
+            if (closed) {
+                return false;
+            }
+            items.emplace_back(std::move(value));
+            not_empty.notify_one();
+            return true;
+        }
+        
+        bool
+        pop(T &value) {
+            std::unique_lock<std::mutex> lock(items_mutex);
+            not_empty.wait(lock, [this]() {
+                return !items.empty() || closed;
+            });
+            if (items.empty()) {
+                return false;
+            }
+            value = std::move(items.front());
+            items.pop_front();
+            not_full.notify_one();
+            return true;
+        }
+        
+        void
+        close() {
+            std::lock_guard<std::mutex> lock(items_mutex);
+            closed = true;
+            not_empty.notify_all();
+            not_full.notify_all();
+        }
+    };
+    
+    /**
+     *group commit: operations queued within commit_window (or until max_batch are waiting) share one transaction
+     */
+    struct async_writer_options {
+        size_t max_batch = 1000;
+        std::chrono::milliseconds commit_window = std::chrono::milliseconds(5);
+    };
+    
+    /**
+     *write-behind queue drained by one writer thread; every operation's future
+     *resolves with its result code once the transaction containing it has committed,
+     *or holds the exception the operation threw
+     */
+    class async_writer {
+    public:
+        typedef std::function<int()> operation;
+    private:
+        struct pending_write {
+            operation op;
+            std::promise<int> done;
+        };
+        
+        std::function<int(const char *)> execute;
+        async_writer_options options;
+        mpsc_queue<std::unique_ptr<pending_write>> queue;
+        std::atomic<size_t> pending;
+        bool stopping = false;
+        std::mutex wake_mutex;
+        std::condition_variable wake;
+        std::thread worker;
+        
+        void
+        run() {
+            std::vector<std::unique_ptr<pending_write>> batch;
+            std::vector<int> results;
+            std::vector<std::exception_ptr> failures;
+            for (;;) {
+                {
+                    std::unique_lock<std::mutex> lock(wake_mutex);
+                    wake.wait(lock, [this]() {
+                        return pending.load() != 0 || stopping;
+                    });
+                    if (pending.load() == 0 && stopping) {
+                        return;
+                    }
+                    auto deadline = std::chrono::steady_clock::now() + options.commit_window;
+                    wake.wait_until(lock, deadline, [this]() {
+                        return pending.load() >= options.max_batch || stopping;
+                    });
+                }
+                
+                std::unique_ptr<pending_write> item;
+                while (batch.size() < options.max_batch && queue.pop(item)) {
+                    batch.emplace_back(std::move(item));
+                }
+                if (batch.empty()) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                pending.fetch_sub(batch.size());
+                
+                results.clear();
+                failures.clear();
+                SQLITE_API int SQLITE_STDCALL begin_err = execute("BEGIN IMMEDIATE");
+                for (std::unique_ptr<pending_write> &write : batch) {
+                    /**
+                     *a throwing operation fails its own future, the rest of the batch still commits
+                     */
+                    try {
+                        results.push_back(write->op());
+                        failures.emplace_back();
+                    } catch (...) {
+                        results.push_back(SQLITE_ERROR);
+                        failures.push_back(std::current_exception());
+                    }
+                }
+                SQLITE_API int SQLITE_STDCALL commit_err = SQLITE_OK;
+                if (begin_err == SQLITE_OK) {
+                    commit_err = execute("COMMIT");
+                    if (commit_err != SQLITE_OK) {
+                        execute("ROLLBACK");
+                    }
+                }
+                for (size_t index = 0; index < batch.size(); index++) {
+                    if (failures.at(index)) {
+                        batch.at(index)->done.set_exception(failures.at(index));
+                    } else {
+                        batch.at(index)->done.set_value(commit_err != SQLITE_OK ? commit_err : results.at(index));
+                    }
+                }
+                batch.clear();
+            }
+        }
+    public:
+        /**
+         *execute runs BEGIN/COMMIT/ROLLBACK on the connection the operations write to
+         */
+        async_writer(std::function<int(const char *)> execute, const async_writer_options &options) : execute(std::move(execute)), options(options), pending(0) {
+            if (this->options.max_batch == 0) {
+                this->options.max_batch = 1;
+            }
+            worker = std::thread(&async_writer::run, this);
+        }
+        
+        /**
+         *drains everything already queued before returning
+         */
+        ~async_writer() {
+            {
+                std::lock_guard<std::mutex> lock(wake_mutex);
+                stopping = true;
+            }
+            wake.notify_one();
+            worker.join();
+        }
+        
+        async_writer(const async_writer &) = delete;
+        async_writer &operator=(const async_writer &) = delete;
+        
+        std::future<int>
+        submit(operation op) {
+            std::unique_ptr<pending_write> write(new pending_write());
+            write->op = std::move(op);
+            std::future<int> result = write->done.get_future();
+            /**
+             *counted before it becomes visible, so the writer never takes more than pending holds
+             */
+            size_t waiting = pending.fetch_add(1) + 1;
+            queue.push(std::move(write));
+            if (waiting == 1 || waiting == options.max_batch) {
+                std::lock_guard<std::mutex> lock(wake_mutex);
+                wake.notify_one();
+            }
+            return result;
+        }
+    };
+    
+    /**
+     *lazy result set: owns a checked-out statement (and the connection it runs on) and decodes one row per sqlite3_step;
+     *must not outlive the sqlite3_delegate that created it
+     */
+    template<typename...T>
+    class sqlite3_cursor {
+    public:
+        typedef std::tuple<T...> row_type;
+        
+        class iterator {
+        private:
+            sqlite3_cursor *owner = nullptr;
+        public:
+            typedef std::input_iterator_tag iterator_category;
+            typedef row_type value_type;
+            typedef std::ptrdiff_t difference_type;
+            typedef row_type *pointer;
+            typedef row_type &reference;
+            
+            iterator() {
+                
+            }
+            
+            explicit iterator(sqlite3_cursor *cursor) : owner(cursor) {
+                
+            }
+            
+            reference operator*() const {
+                return owner->current;
+            }
+            
+            pointer operator->() const {
+                return &owner->current;
+            }
+            
+            iterator &operator++() {
+                if (!owner->next()) {
+                    owner = nullptr;
+                }
+                return *this;
+            }
+            
+            void operator++(int) {
+                ++(*this);
+            }
+            
+            bool operator==(const iterator &other) const {
+                return owner == other.owner;
+            }
+            
+            bool operator!=(const iterator &other) const {
+                return owner != other.owner;
+            }
+        };
+    private:
+        connection_lease lease;
+        sqlite3_stmt *stmt = nullptr;
+        row_type current;
+        SQLITE_API int SQLITE_STDCALL last_err = SQLITE_OK;
+        bool started = false;
+        bool has_row = false;
+        
+        void
+        sqlite3_cursor_rv(sqlite3_cursor &&obj) {
+            std::swap(lease, obj.lease);
+            std::swap(stmt, obj.stmt);
+            std::swap(current, obj.current);
+            std::swap(last_err, obj.last_err);
+            std::swap(started, obj.started);
+            std::swap(has_row, obj.has_row);
+        }
+    public:
+        sqlite3_cursor() {
+            
+        }
+        
+        sqlite3_cursor(connection_lease &&lease, sqlite3_stmt *stmt, int err) : lease(std::move(lease)), stmt(stmt), last_err(err) {
+            
+        }
+        
+        ~sqlite3_cursor() {
+            close();
+        }
+        
+        sqlite3_cursor(const sqlite3_cursor &) = delete;
+        sqlite3_cursor(sqlite3_cursor &&obj) {
+            sqlite3_cursor_rv(std::forward<sqlite3_cursor>(obj));
+        }
+        
+        sqlite3_cursor &operator=(const sqlite3_cursor &) = delete;
+        sqlite3_cursor &operator=(sqlite3_cursor &&obj) {
+            sqlite3_cursor_rv(std::forward<sqlite3_cursor>(obj));
+            return *this;
+        }
+        
+        /**
+         *step to the next row, false once the result set is exhausted or an error occurred
+         */
+        bool
+        next() {
+            started = true;
+            has_row = false;
+            if (stmt == nullptr) {
+                return false;
+            }
+            SQLITE_API int SQLITE_STDCALL step_err = sqlite3_step(stmt);
+            if (step_err == SQLITE_ROW) {
+                tuple_utility::get_row(stmt, current);
+                has_row = true;
+                return true;
+            }
+            last_err = step_err == SQLITE_DONE ? SQLITE_OK : step_err;
+            close();
+            return false;
+        }
+        
+        const row_type &
+        row() const {
+            return current;
+        }
+        
+        /**
+         *stop early, the statement goes back to the connection's cache and the connection to its pool
+         */
+        void
+        close() {
+            if (stmt != nullptr) {
+                lease.release(stmt);
+                stmt = nullptr;
+            }
+            lease = connection_lease();
+        }
+        
+        /**
+         *SQLITE_OK unless preparing or stepping failed
+         */
+        SQLITE_API int SQLITE_STDCALL
+        error() const {
+            return last_err;
+        }
+        
+        iterator
+        begin() {
+            if (!started) {
+                next();
+            }
+            return has_row ? iterator(this) : iterator();
+        }
+        
+        iterator
+        end() {
+            return iterator();
+        }
+    };
+
+    /**
+     *threads taking tasks from one queue in order; the destructor runs what is still queued
+     */
+    class work_lane {
+    private:
+        std::deque<std::function<void()>> tasks;
+        bool stopping = false;
+        std::mutex tasks_mutex;
+        std::condition_variable wake;
+        std::vector<std::thread> workers;
+        
+        void
+        run() {
+            for (;;) {
+                std::function<void()> task;
+                {
+                    std::unique_lock<std::mutex> lock(tasks_mutex);
+                    wake.wait(lock, [this]() {
+                        return !tasks.empty() || stopping;
+                    });
+                    if (tasks.empty()) {
+                        return;
+                    }
+                    task = std::move(tasks.front());
+                    tasks.pop_front();
+                }
+                /**
+                 *tasks hand their failures to whoever waits on them, one that throws anyway must not stop the lane
+                 */
+                try {
+                    task();
+                } catch (...) {
+                    
+                }
+            }
+        }
+    public:
+        explicit work_lane(size_t thread_count) {
+            for (size_t index = 0; index < std::max<size_t>(thread_count, 1); index++) {
+                workers.emplace_back(&work_lane::run, this);
+            }
+        }
+        
+        ~work_lane() {
+            {
+                std::lock_guard<std::mutex> lock(tasks_mutex);
+                stopping = true;
+            }
+            wake.notify_all();
+            for (std::thread &worker : workers) {
+                worker.join();
+            }
+        }
+        
+        work_lane(const work_lane &) = delete;
+        work_lane &operator=(const work_lane &) = delete;
+        
+        void
+        post(std::function<void()> task) {
+            {
+                std::lock_guard<std::mutex> lock(tasks_mutex);
+                tasks.emplace_back(std::move(task));
+            }
+            wake.notify_one();
+        }
+    };
+    
+    struct executor_options {
+        /**
+         *threads running queries when the reader pool is open, 0 runs them on the write thread too
+         */
+        size_t read_threads = 2;
+        /**
+         *receives the continuation of a finished operation, e.g. to post it to an event loop;
+         *empty resumes the caller on the executor thread
+         */
+        std::function<void(std::function<void()>)> resume;
+    };
+    
+    /**
+     *one thread owning the writing connection and a few running queries on pooled readers
+     */
+    class query_executor {
+    private:
+        executor_options options;
+        work_lane writes;
+        std::unique_ptr<work_lane> reads;
+    public:
+        explicit query_executor(const executor_options &options) : options(options), writes(1) {
+            if (options.read_threads != 0) {
+                reads.reset(new work_lane(options.read_threads));
+            }
+        }
+        
+        query_executor(const query_executor &) = delete;
+        query_executor &operator=(const query_executor &) = delete;
+        
+        void
+        post(bool on_writer, std::function<void()> task) {
+            if (on_writer || !reads) {
+                writes.post(std::move(task));
+            }
+            else {
+                reads->post(std::move(task));
+            }
+        }
+        
+        void
+        resume(std::function<void()> continuation) {
+            if (options.resume) {
+                options.resume(std::move(continuation));
+            }
+            else {
+                continuation();
+            }
+        }
+    };
+    
+#if SQLXX_HAS_COROUTINES
+    /**
+     *co_await runs work on the executor and resumes the awaiting coroutine with its result,
+     *or rethrows in the coroutine what work threw; without an executor work runs inline when awaited
+     */
+    template<typename T>
+    class sqlite3_awaitable {
+    private:
+        query_executor *executor;
+        bool on_writer;
+        std::function<T()> work;
+        T value;
+        std::exception_ptr error;
+    public:
+        sqlite3_awaitable(query_executor *executor, bool on_writer, std::function<T()> work)
+        : executor(executor), on_writer(on_writer), work(std::move(work)), value() {
+            
+        }
+        
+        bool
+        await_ready() const noexcept {
+            return executor == nullptr;
+        }
+        
+        void
+        await_suspend(std::coroutine_handle<> awaiting) {
+            executor->post(on_writer, [this, awaiting]() {
+                try {
+                    value = work();
+                } catch (...) {
+                    error = std::current_exception();
+                }
+                executor->resume([awaiting]() {
+                    awaiting.resume();
+                });
+            });
+        }
+        
+        T
+        await_resume() {
+            if (executor == nullptr) {
+                return work();
+            }
+            if (error) {
+                std::rethrow_exception(error);
+            }
+            return std::move(value);
+        }
+    };
+    
+    /**
+     *rows of a query in batches of up to batch_rows, each batch stepped on the executor:
+     *while (co_await rows.next()) { for (auto &row : rows.batch()) { ... } }
+     */
+    template<typename...T>
+    class sqlite3_batch_cursor {
+    public:
+        typedef std::tuple<T...> row_type;
+    private:
+        query_executor *executor = nullptr;
+        bool on_writer = true;
+        size_t batch_rows = 1;
+        std::function<sqlite3_cursor<T...>()> open;
+        std::shared_ptr<sqlite3_cursor<T...>> cursor;
+        std::vector<row_type> rows;
+        SQLITE_API int SQLITE_STDCALL last_err = SQLITE_OK;
+        bool finished = false;
+        
+        bool
+        fill() {
+            rows.clear();
+            if (finished) {
+                return false;
+            }
+            if (!cursor) {
+                cursor = std::make_shared<sqlite3_cursor<T...>>(open());
+            }
+            while (rows.size() < batch_rows && cursor->next()) {
+                rows.push_back(cursor->row());
+            }
+            if (rows.size() < batch_rows) {
+                last_err = cursor->error();
+                finished = true;
+                cursor.reset();
+            }
+            return !rows.empty();
+        }
+    public:
+        sqlite3_batch_cursor(query_executor *executor, bool on_writer, size_t batch_rows, std::function<sqlite3_cursor<T...>()> open)
+        : executor(executor), on_writer(on_writer), batch_rows(std::max<size_t>(batch_rows, 1)), open(std::move(open)) {
+            
+        }
+        
+        /**
+         *a statement left open goes back to its connection on the executor
+         */
+        ~sqlite3_batch_cursor() {
+            if (cursor && executor != nullptr) {
+                std::shared_ptr<sqlite3_cursor<T...>> unfinished = std::move(cursor);
+                executor->post(on_writer, [unfinished]() {
+                    unfinished->close();
+                });
+            }
+        }
+        
+        sqlite3_batch_cursor(const sqlite3_batch_cursor &) = delete;
+        sqlite3_batch_cursor &operator=(const sqlite3_batch_cursor &) = delete;
+        
+        /**
+         *true with a new batch, false once the rows are exhausted or an error occurred
+         */
+        sqlite3_awaitable<bool>
+        next() {
+            return sqlite3_awaitable<bool>(executor, on_writer, [this]() {
+                return fill();
+            });
+        }
+        
+        const std::vector<row_type> &
+        batch() const {
+            return rows;
+        }
+        
+        /**
+         *SQLITE_OK unless preparing or stepping failed
+         */
+        SQLITE_API int SQLITE_STDCALL
+        error() const {
+            return last_err;
+        }
+    };
+#endif
+
+    /**
+     *value bound to a ? placeholder of a typed condition
+     */
+    class bound_value {
+    private:
+        SQLITE_API int SQLITE_STDCALL type = SQLITE_NULL;
+        integer int_value = 0;
+        real real_value = 0.0;
+        char_string text_value;
+        data_string blob_value;
+    public:
+        /**
+         *any integral value binds as INTEGER (unsigned values above INT64_MAX wrap), any floating point one as REAL
+         */
+        template<typename T, typename std::enable_if<std::is_integral<T>::value, int>::type = 0>
+        bound_value(T value) : type(SQLITE_INTEGER), int_value(static_cast<integer>(value)) {
+            
+        }
+        
+        template<typename T, typename std::enable_if<std::is_floating_point<T>::value, int>::type = 0>
+        bound_value(T value) : type(SQLITE_FLOAT), real_value(static_cast<real>(value)) {
+            
+        }
+        
+        bound_value(char_string value) : type(SQLITE_TEXT), text_value(std::move(value)) {
+            
+        }
+        
+        bound_value(const char *value) : type(SQLITE_TEXT), text_value(value) {
+            
+        }
+        
+        bound_value(data_string value) : type(SQLITE_BLOB), blob_value(std::move(value)) {
+            
+        }
+        
+        /**
+         *SQLITE_INTEGER, SQLITE_FLOAT, SQLITE_TEXT, SQLITE_BLOB or SQLITE_NULL
+         */
+        SQLITE_API int SQLITE_STDCALL
+        storage_class() const {
+            return type;
+        }
+        
+        SQLITE_API int SQLITE_STDCALL
+        bind(sqlite3_stmt *stmt, int index) const {
+            switch (type) {
+                case SQLITE_INTEGER:
+                    return bind_utility::bind_parameter(stmt, index, int_value);
+                case SQLITE_FLOAT:
+                    return bind_utility::bind_parameter(stmt, index, real_value);
+                case SQLITE_TEXT:
+                    return bind_utility::bind_parameter(stmt, index, text_value);
+                case SQLITE_BLOB:
+                    return bind_utility::bind_parameter(stmt, index, blob_value);
+                default:
+                    return sqlite3_bind_null(stmt, index);
+            }
+        }
+        
+        /**
+         *the value as sql text, for statements that cannot take parameters (a partial index WHERE)
+         */
+        std::string
+        literal() const {
+            switch (type) {
+                case SQLITE_INTEGER:
+                    return std::to_string(int_value);
+                case SQLITE_FLOAT: {
+                    char text[32];
+                    snprintf(text, sizeof(text), "%.17g", real_value);
+                    return text;
+                }
+                case SQLITE_TEXT: {
+                    std::string quoted("'");
+                    for (char c : text_value) {
+                        if (c == '\'') {
+                            quoted.push_back('\'');
+                        }
+                        quoted.push_back(c);
+                    }
+                    quoted.push_back('\'');
+                    return quoted;
+                }
+                case SQLITE_BLOB: {
+                    static const char digits[] = "0123456789ABCDEF";
+                    std::string hex("X'");
+                    for (any_mem_t byte : blob_value) {
+                        hex.push_back(digits[byte >> 4]);
+                        hex.push_back(digits[byte & 0x0f]);
+                    }
+                    hex.push_back('\'');
+                    return hex;
+                }
+                default:
+                    return "NULL";
+            }
+        }
+    };
+    
+    /**
+     *typed WHERE clause: column references are resolved to names when rendered,
+     *values are never written into the sql text but bound to ? placeholders, so
+     *the same shape with different values renders the same sql
+     */
+    class sqlite3_condition {
+    private:
+        /**
+         *sql text, or a column reference when column != no_column()
+         */
+        typedef std::pair<size_t, std::string> part;
+        
+        std::vector<part> parts;
+        std::vector<bound_value> values;
+        
+        static size_t
+        no_column() {
+            return size_t(-1);
+        }
+        
+        void
+        append_text(std::string text) {
+            parts.emplace_back(no_column(), std::move(text));
+        }
+        
+        void
+        append_condition(const sqlite3_condition &other) {
+            append_text("(");
+            parts.insert(parts.end(), other.parts.begin(), other.parts.end());
+            values.insert(values.end(), other.values.begin(), other.values.end());
+            append_text(")");
+        }
+        
+        static sqlite3_condition
+        combine(const sqlite3_condition &left, const char *op, const sqlite3_condition &right) {
+            sqlite3_condition condition;
+            condition.append_condition(left);
+            condition.append_text(op);
+            condition.append_condition(right);
+            return condition;
+        }
+    public:
+        sqlite3_condition() {
+            
+        }
+        
+        /**
+         *column operator ?
+         */
+        static sqlite3_condition
+        compare(size_t column, const char *op, bound_value value) {
+            sqlite3_condition condition;
+            condition.parts.emplace_back(column, std::string());
+            condition.append_text(op);
+            condition.append_text("?");
+            condition.values.emplace_back(std::move(value));
+            return condition;
+        }
+        
+        /**
+         *column followed by a fixed suffix such as " IS NULL"
+         */
+        static sqlite3_condition
+        column_suffix(size_t column, const char *suffix) {
+            sqlite3_condition condition;
+            condition.parts.emplace_back(column, std::string());
+            condition.append_text(suffix);
+            return condition;
+        }
+        
+        bool
+        empty() const {
+            return parts.empty();
+        }
+        
+        std::string
+        render(const std::vector<std::string> &column_names) const {
+            std::string sqlcmd;
+            for (const part &item : parts) {
+                if (item.first == no_column()) {
+                    sqlcmd.append(item.second);
+                }
+                else {
+                    sqlcmd.append(column_names.at(item.first));
+                }
+            }
+            return sqlcmd;
+        }
+        
+        /**
+         *render with every ? replaced by its value written as a literal
+         */
+        std::string
+        render_literal(const std::vector<std::string> &column_names) const {
+            std::string sqlcmd;
+            size_t next_value = 0;
+            for (const part &item : parts) {
+                if (item.first != no_column()) {
+                    sqlcmd.append(column_names.at(item.first));
+                }
+                else if (item.second == "?") {
+                    sqlcmd.append(values.at(next_value++).literal());
+                }
+                else {
+                    sqlcmd.append(item.second);
+                }
+            }
+            return sqlcmd;
+        }
+        
+        const std::vector<bound_value> &
+        parameters() const {
+            return values;
+        }
+        
+        friend sqlite3_condition
+        operator&&(const sqlite3_condition &left, const sqlite3_condition &right) {
+            return combine(left, " AND ", right);
+        }
+        
+        friend sqlite3_condition
+        operator||(const sqlite3_condition &left, const sqlite3_condition &right) {
+            return combine(left, " OR ", right);
+        }
+        
+        friend sqlite3_condition
+        operator!(const sqlite3_condition &operand) {
+            sqlite3_condition condition;
+            condition.append_text("NOT ");
+            condition.append_condition(operand);
+            return condition;
+        }
+    };
+    
+    /**
+     *column reference of a typed condition, column index start from 0:
+     *col<0>() > integer(5) && col<2>() == char_string("x")
+     */
+    template<size_t index>
+    struct column_ref {
+        sqlite3_condition
+        is_null() const {
+            return sqlite3_condition::column_suffix(index, " IS NULL");
+        }
+        
+        sqlite3_condition
+        is_not_null() const {
+            return sqlite3_condition::column_suffix(index, " IS NOT NULL");
+        }
+        
+        sqlite3_condition
+        like(char_string pattern) const {
+            return sqlite3_condition::compare(index, " LIKE ", bound_value(std::move(pattern)));
+        }
+    };
+    
+    template<size_t index>
+    column_ref<index>
+    col() {
+        return column_ref<index>();
+    }
+    
+    template<size_t index, typename T>
+    sqlite3_condition
+    operator==(column_ref<index>, T value) {
+        return sqlite3_condition::compare(index, "=", bound_value(std::move(value)));
+    }
+    
+    template<size_t index, typename T>
+    sqlite3_condition
+    operator!=(column_ref<index>, T value) {
+        return sqlite3_condition::compare(index, "<>", bound_value(std::move(value)));
+    }
+    
+    template<size_t index, typename T>
+    sqlite3_condition
+    operator<(column_ref<index>, T value) {
+        return sqlite3_condition::compare(index, "<", bound_value(std::move(value)));
+    }
+    
+    template<size_t index, typename T>
+    sqlite3_condition
+    operator<=(column_ref<index>, T value) {
+        return sqlite3_condition::compare(index, "<=", bound_value(std::move(value)));
+    }
+    
+    template<size_t index, typename T>
+    sqlite3_condition
+    operator>(column_ref<index>, T value) {
+        return sqlite3_condition::compare(index, ">", bound_value(std::move(value)));
+    }
+    
+    template<size_t index, typename T>
+    sqlite3_condition
+    operator>=(column_ref<index>, T value) {
+        return sqlite3_condition::compare(index, ">=", bound_value(std::move(value)));
+    }
+    
+    /**
+     *aggregate functions for sqlite3_delegate::aggregate and group_by, result<T>::type is what
+     *the SQL function returns for a column of type T
+     */
+    namespace agg {
+        struct count {
+            static const char *function() { return "count"; }
+            
+            template<typename T>
+            struct result {
+                typedef integer type;
+            };
+        };
+        
+        struct sum {
+            static const char *function() { return "sum"; }
+            
+            template<typename T>
+            struct result {
+                static_assert(std::is_arithmetic<T>::value, "sum needs an INTEGER or REAL column");
+                typedef T type;
+            };
+        };
+        
+        struct avg {
+            static const char *function() { return "avg"; }
+            
+            template<typename T>
+            struct result {
+                static_assert(std::is_arithmetic<T>::value, "avg needs an INTEGER or REAL column");
+                typedef real type;
+            };
+        };
+        
+        struct min {
+            static const char *function() { return "min"; }
+            
+            template<typename T>
+            struct result {
+                typedef T type;
+            };
+        };
+        
+        struct max {
+            static const char *function() { return "max"; }
+            
+            template<typename T>
+            struct result {
+                typedef T type;
+            };
+        };
+    }
+
+    /**
+     *secondary index created with the table, where is the partial index condition (empty for a full index)
+     */
+    struct index_definition {
+        std::string name;
+        std::vector<size_t> columns;
+        bool unique = false;
+        sqlite3_condition where;
+    };
+    
+    /**
+     *EXPLAIN QUERY PLAN output, one step per row; detail is SQLite's text such as
+     *"SCAN t" or "SEARCH t USING INDEX t_a_idx (a=?)"
+     */
+    struct query_plan {
+        struct step {
+            int id = 0;
+            int parent = 0;
+            std::string detail;
+        };
+        
+        std::vector<step> steps;
+        
+        /**
+         *some table is read start to end without an index (older SQLite versions print "SCAN TABLE");
+         *a "SCAN t USING [COVERING] INDEX ..." step walks an index and is not counted
+         */
+        bool
+        full_scan() const {
+            for (const step &item : steps) {
+                if (item.detail.compare(0, 5, "SCAN ") == 0 && item.detail.find(" INDEX ") == std::string::npos) {
+                    return true;
+                }
+            }
+            return false;
+        }
+        
+        bool
+        uses_index() const {
+            for (const step &item : steps) {
+                if (item.detail.compare(0, 7, "SEARCH ") == 0 || item.detail.find(" INDEX ") != std::string::npos) {
+                    return true;
+                }
+            }
+            return false;
+        }
+        
+        std::string
+        to_string() const {
+            std::string text;
+            for (const step &item : steps) {
+                text.append(item.detail);
+                text.append("\n");
+            }
+            return text;
+        }
+    };
+
+    /**
+     *where a keyset page ended: the sort value and rowid of its last row;
+     *a default token asks for the first page, finished is set once no rows are left
+     */
+    template<typename KEY>
+    struct page_token {
+        bool started = false;
+        bool finished = false;
+        KEY key = KEY();
+        integer rowid = 0;
+    };
+    
+    template<typename KEY, typename...T>
+    struct value_page {
+        std::deque<std::tuple<T...>> rows;
+        page_token<KEY> next;
+        SQLITE_API int SQLITE_STDCALL error = SQLITE_OK;
+    };
+
+    struct backup_progress {
+        int remaining = 0;
+        int page_count = 0;
+        
+        double
+        fraction() const {
+            return page_count == 0 ? 1.0 : double(page_count - remaining) / double(page_count);
+        }
+    };
+    
+    /**
+     *an online backup copies pages_per_step pages per sqlite3_backup_step (a negative value copies
+     *everything in one step) and sleeps pause between steps, the source is only locked during a step;
+     *progress is called after every step, returning false abandons the backup; a step that keeps
+     *failing with SQLITE_BUSY or SQLITE_LOCKED is retried for at most busy_timeout (0 gives up at once)
+     */
+    struct backup_options {
+        int pages_per_step = 256;
+        std::chrono::milliseconds pause = std::chrono::milliseconds(1);
+        std::chrono::milliseconds busy_timeout = std::chrono::milliseconds(5000);
+        std::function<bool(const backup_progress &)> progress;
+    };
+    
+    /**
+     *a private :memory: connection that holds a snapshot taken by sqlite3_delegate::snapshot_to_memory
+     */
+    class memory_database {
+    private:
+        sqlite3 *db = nullptr;
+    public:
+        memory_database() {
+            
+        }
+        
+        ~memory_database() {
+            close();
+        }
+        
+        memory_database(const memory_database &) = delete;
+        memory_database &operator=(const memory_database &) = delete;
+        
+        memory_database(memory_database &&obj) {
+            std::swap(db, obj.db);
+        }
+        
+        memory_database &operator=(memory_database &&obj) {
+            std::swap(db, obj.db);
+            return *this;
+        }
+        
+        SQLITE_API int SQLITE_STDCALL
+        open() {
+            if (db != nullptr) {
+                return SQLITE_OK;
+            }
+            SQLITE_API int SQLITE_STDCALL open_err = sqlite3_open(":memory:", &db);
+            if (open_err != SQLITE_OK) {
+                close();
+            }
+            return open_err;
+        }
+        
+        void
+        close() {
+            if (db != nullptr) {
+                sqlite3_close(db);
+                db = nullptr;
+            }
+        }
+        
+        sqlite3 *
+        handle() const {
+            return db;
+        }
+    };
+    
+    class backup_utility {
+    public:
+        /**
+         *copy pages from source into target step by step, SQLITE_BUSY and SQLITE_LOCKED from a step
+         *are retried after the pause and returned once they have lasted options.busy_timeout;
+         *SQLITE_ABORT when options.progress stopped the copy
+         */
+        SQLITE_API int SQLITE_STDCALL
+        static backup(sqlite3 *target, sqlite3 *source, const backup_options &options) {
+            sqlite3_backup *copy = sqlite3_backup_init(target, "main", source, "main");
+            if (copy == nullptr) {
+                return sqlite3_errcode(target);
+            }
+            SQLITE_API int SQLITE_STDCALL step_err = SQLITE_OK;
+            int pages = options.pages_per_step == 0 ? 1 : options.pages_per_step;
+            std::chrono::steady_clock::time_point busy_since;
+            bool busy = false;
+            for (;;) {
+                step_err = sqlite3_backup_step(copy, pages);
+                if (step_err != SQLITE_OK && step_err != SQLITE_BUSY && step_err != SQLITE_LOCKED) {
+                    break;
+                }
+                if (step_err == SQLITE_OK) {
+                    busy = false;
+                }
+                else if (!busy) {
+                    busy = true;
+                    busy_since = std::chrono::steady_clock::now();
+                }
+                if (busy && std::chrono::steady_clock::now() - busy_since >= options.busy_timeout) {
+                    break;
+                }
+                if (options.progress) {
+                    backup_progress progress;
+                    progress.remaining = sqlite3_backup_remaining(copy);
+                    progress.page_count = sqlite3_backup_pagecount(copy);
+                    if (!options.progress(progress)) {
+                        step_err = SQLITE_ABORT;
+                        break;
+                    }
+                }
+                if (options.pause.count() > 0) {
+                    std::this_thread::sleep_for(options.pause);
+                }
+                else {
+                    std::this_thread::yield();
+                }
+            }
+            if (step_err == SQLITE_DONE && options.progress) {
+                backup_progress progress;
+                progress.page_count = sqlite3_backup_pagecount(copy);
+                options.progress(progress);
+            }
+            SQLITE_API int SQLITE_STDCALL finish_err = sqlite3_backup_finish(copy);
+            return step_err == SQLITE_DONE ? finish_err : step_err;
+        }
+    };
+
+    /**
+     *in-memory working set: committed writes reach the file flush_interval (plus the time of one flush)
+     *after they were made, as long as the memory connection is then outside a transaction; a flush that
+     *finds one open is retried every busy_retry until it gets through, and the flush error reports
+     *SQLITE_BUSY once it is a whole flush_interval late. 0 disables the timer, leaving flush() and shutdown
+     */
+    struct memory_mode_options {
+        std::chrono::milliseconds flush_interval = std::chrono::milliseconds(1000);
+        std::chrono::milliseconds busy_retry = std::chrono::milliseconds(5);
+        /**
+         *pacing of the copy into the file, the in-memory connection is not locked while it runs
+         */
+        backup_options flush_backup = backup_options();
+    };
+    
+    /**
+     *keeps a file in step with an in-memory connection: a flush first copies the memory database into
+     *a staging copy while holding the connection's mutex (a memory to memory copy, so writers wait
+     *only for that), then writes the staging copy into the file step by step
+     */
+    class memory_flusher {
+    private:
+        sqlite3 *source = nullptr;
+        sqlite3 *file_db = nullptr;
+        memory_database staging;
+        memory_mode_options options;
+        std::pair<int, int> flushed_version;
+        std::atomic<int> background_err;
+        std::mutex flush_mutex;
+        bool stopping = false;
+        std::mutex wake_mutex;
+        std::condition_variable wake;
+        std::thread worker;
+        
+        /**
+         *total changes and schema version, either moves when the memory database is written
+         */
+        static std::pair<int, int>
+        version(sqlite3 *db) {
+            int schema = 0;
+            sqlite3_exec(db, "PRAGMA schema_version", [](void *result, int, char **values, char **) -> int {
+                if (values[0] != nullptr) {
+                    *reinterpret_cast<int *>(result) = atoi(values[0]);
+                }
+                return 0;
+            }, &schema, NULL);
+            return std::make_pair(sqlite3_total_changes(db), schema);
+        }
+        
+        void
+        run() {
+            std::unique_lock<std::mutex> lock(wake_mutex);
+            std::chrono::milliseconds wait = options.flush_interval;
+            std::chrono::steady_clock::time_point due = std::chrono::steady_clock::now() + wait;
+            while (!stopping) {
+                wake.wait_for(lock, wait, [this]() {
+                    return stopping;
+                });
+                if (stopping) {
+                    break;
+                }
+                lock.unlock();
+                SQLITE_API int SQLITE_STDCALL err = flush();
+                lock.lock();
+                std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+                if (err == SQLITE_BUSY) {
+                    if (now - due > options.flush_interval) {
+                        background_err.store(SQLITE_BUSY);
+                    }
+                    wait = std::max(options.busy_retry, std::chrono::milliseconds(1));
+                    continue;
+                }
+                background_err.store(err);
+                wait = options.flush_interval;
+                due = now + wait;
+            }
+        }
+    public:
+        memory_flusher() : background_err(SQLITE_OK) {
+            
+        }
+        
+        /**
+         *stops the timer and flushes one last time; a transaction still open on the memory connection
+         *is rolled back first, closing the connection would discard it all the same
+         */
+        ~memory_flusher() {
+            if (worker.joinable()) {
+                {
+                    std::lock_guard<std::mutex> lock(wake_mutex);
+                    stopping = true;
+                }
+                wake.notify_one();
+                worker.join();
+            }
+            if (source != nullptr && flush() == SQLITE_BUSY) {
+                sqlite3_exec(source, "ROLLBACK", NULL, NULL, NULL);
+                flush();
+            }
+            staging.close();
+            if (file_db != nullptr) {
+                sqlite3_close(file_db);
+            }
+        }
+        
+        memory_flusher(const memory_flusher &) = delete;
+        memory_flusher &operator=(const memory_flusher &) = delete;
+        
+        /**
+         *loads the file at path into memory_db (a missing file starts empty) and starts the timer;
+         *memory_db must be opened with SQLITE_OPEN_FULLMUTEX, the flush thread shares it
+         */
+        SQLITE_API int SQLITE_STDCALL
+        start(sqlite3 *memory_db, const std::string &path, const memory_mode_options &mode) {
+            options = mode;
+            /**
+             *loaded through a connection of its own, so file_db is only ever a backup target
+             */
+            sqlite3 *load_db = nullptr;
+            SQLITE_API int SQLITE_STDCALL err = sqlite3_open(path.c_str(), &load_db);
+            if (err == SQLITE_OK) {
+                backup_options load;
+                load.pages_per_step = -1;
+                err = backup_utility::backup(memory_db, load_db, load);
+            }
+            sqlite3_close(load_db);
+            if (err == SQLITE_OK) {
+                err = sqlite3_open(path.c_str(), &file_db);
+            }
+            if (err == SQLITE_OK) {
+                err = staging.open();
+            }
+            if (err != SQLITE_OK) {
+                sqlite3_close(file_db);
+                file_db = nullptr;
+                return err;
+            }
+            source = memory_db;
+            flushed_version = version(source);
+            if (options.flush_interval.count() > 0) {
+                worker = std::thread(&memory_flusher::run, this);
+            }
+            return SQLITE_OK;
+        }
+        
+        /**
+         *copies committed state to the file if anything changed since the last flush;
+         *SQLITE_BUSY while a transaction is open on the memory connection
+         */
+        SQLITE_API int SQLITE_STDCALL
+        flush() {
+            std::lock_guard<std::mutex> lock(flush_mutex);
+            std::pair<int, int> current;
+            SQLITE_API int SQLITE_STDCALL err = SQLITE_OK;
+            sqlite3_mutex *source_mutex = sqlite3_db_mutex(source);
+            sqlite3_mutex_enter(source_mutex);
+            if (!sqlite3_get_autocommit(source)) {
+                err = SQLITE_BUSY;
+            }
+            else {
+                current = version(source);
+                if (current == flushed_version) {
+                    sqlite3_mutex_leave(source_mutex);
+                    return SQLITE_OK;
+                }
+                backup_options whole;
+                whole.pages_per_step = -1;
+                err = backup_utility::backup(staging.handle(), source, whole);
+            }
+            sqlite3_mutex_leave(source_mutex);
+            if (err != SQLITE_OK) {
+                return err;
+            }
+            err = backup_utility::backup(file_db, staging.handle(), options.flush_backup);
+            if (err == SQLITE_OK) {
+                flushed_version = current;
+            }
+            return err;
+        }
+        
+        /**
+         *result of the last timed flush; SQLITE_BUSY while a flush is a whole flush_interval overdue
+         */
+        SQLITE_API int SQLITE_STDCALL
+        error() const {
+            return background_err.load();
+        }
+    };
+
+    struct result_cache_statistics {
+        size_t hits = 0;
+        size_t misses = 0;
+        size_t evictions = 0;
+        size_t invalidations = 0;
+        size_t entries = 0;
+        size_t bytes = 0;
+    };
+    
+    /**
+     *query results keyed by sql text and parameter values, least recently used entries are evicted
+     *to stay within max_bytes; invalidate() drops everything and moves the generation on, so a
+     *result read before an invalidation is not stored after it
+     */
+    class result_cache {
+    private:
+        struct cache_entry {
+            std::string key;
+            std::shared_ptr<const void> rows;
+            size_t bytes;
+        };
+        
+        std::list<cache_entry> entries;
+        std::unordered_map<std::string, std::list<cache_entry>::iterator> entry_index;
+        size_t max_bytes;
+        size_t used_bytes = 0;
+        result_cache_statistics counters;
+        std::atomic<uint64_t> current_generation;
+        std::mutex entries_mutex;
+        
+        /**
+         *PRAGMA data_version on a read only connection of the cache's own, so any thread may check it;
+         *moves when another connection (the delegate's included) commits
+         */
+        sqlite3 *version_db = nullptr;
+        sqlite3_stmt *version_stmt = nullptr;
+        integer last_version = -1;
+        std::mutex version_mutex;
+        
+        void
+        evict_over_capacity() {
+            while (used_bytes > max_bytes && !entries.empty()) {
+                cache_entry &last = entries.back();
+                used_bytes -= last.bytes;
+                entry_index.erase(last.key);
+                entries.pop_back();
+                counters.evictions++;
+            }
+        }
+    public:
+        explicit result_cache(size_t max_bytes) : max_bytes(max_bytes), current_generation(0) {
+            
+        }
+        
+        ~result_cache() {
+            detach();
+        }
+        
+        result_cache(const result_cache &) = delete;
+        result_cache &operator=(const result_cache &) = delete;
+        
+        /**
+         *sql text, then every parameter as its storage class and literal, so equal conditions give
+         *equal keys (integer 1 and real 1.0 share a literal but not the rows they match)
+         */
+        static std::string
+        make_key(const std::string &sqlcmd, const std::vector<bound_value> &values) {
+            std::string key(sqlcmd);
+            for (const bound_value &value : values) {
+                key.push_back('\0');
+                key.push_back(char('0' + value.storage_class()));
+                key.append(value.literal());
+            }
+            return key;
+        }
+        
+        /**
+         *watch the database file for commits made by other connections
+         */
+        SQLITE_API int SQLITE_STDCALL
+        attach(const std::string &path, const open_options &options) {
+            detach();
+            std::lock_guard<std::mutex> lock(version_mutex);
+            SQLITE_API int SQLITE_STDCALL open_err = sqlite3_open_v2(path.c_str(), &version_db, SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX, NULL);
+            if (open_err == SQLITE_OK && options.busy_timeout >= 0) {
+                open_err = sqlite3_busy_timeout(version_db, options.busy_timeout);
+            }
+            if (open_err == SQLITE_OK) {
+                open_err = sqlite3_prepare_v2(version_db, "PRAGMA data_version", -1, &version_stmt, NULL);
+            }
+            if (open_err != SQLITE_OK) {
+                sqlite3_finalize(version_stmt);
+                version_stmt = nullptr;
+                sqlite3_close(version_db);
+                version_db = nullptr;
+            }
+            return open_err;
+        }
+        
+        void
+        detach() {
+            std::lock_guard<std::mutex> lock(version_mutex);
+            sqlite3_finalize(version_stmt);
+            version_stmt = nullptr;
+            if (version_db) {
+                sqlite3_close(version_db);
+                version_db = nullptr;
+            }
+        }
+        
+        /**
+         *invalidate when another connection committed since the last check, or when that cannot be told
+         */
+        void
+        check_data_version() {
+            integer version = -1;
+            {
+                std::lock_guard<std::mutex> lock(version_mutex);
+                if (version_stmt == nullptr) {
+                    return;
+                }
+                if (sqlite3_step(version_stmt) == SQLITE_ROW) {
+                    version = sqlite3_column_int64(version_stmt, 0);
+                }
+                sqlite3_reset(version_stmt);
+                if (version != -1 && version == last_version) {
+                    return;
+                }
+                last_version = version;
+            }
+            invalidate();
+        }
+        
+        uint64_t
+        generation() const {
+            return current_generation.load();
+        }
+        
+        std::shared_ptr<const void>
+        find(const std::string &key) {
+            std::lock_guard<std::mutex> lock(entries_mutex);
+            auto found = entry_index.find(key);
+            if (found == entry_index.end()) {
+                counters.misses++;
+                return std::shared_ptr<const void>();
+            }
+            counters.hits++;
+            entries.splice(entries.begin(), entries, found->second);
+            return found->second->rows;
+        }
+        
+        /**
+         *stored only if nothing was invalidated since generation was read and it fits at all
+         */
+        void
+        insert(std::string key, std::shared_ptr<const void> rows, size_t bytes, uint64_t generation) {
+            bytes += key.size();
+            std::lock_guard<std::mutex> lock(entries_mutex);
+            if (generation != current_generation.load() || bytes > max_bytes || entry_index.count(key) != 0) {
+                return;
+            }
+            cache_entry entry;
+            entry.key = std::move(key);
+            entry.rows = std::move(rows);
+            entry.bytes = bytes;
+            entries.emplace_front(std::move(entry));
+            entry_index[entries.front().key] = entries.begin();
+            used_bytes += bytes;
+            evict_over_capacity();
+        }
+        
+        void
+        invalidate() {
+            std::lock_guard<std::mutex> lock(entries_mutex);
+            current_generation.fetch_add(1);
+            if (!entries.empty()) {
+                counters.invalidations++;
+            }
+            entries.clear();
+            entry_index.clear();
+            used_bytes = 0;
+        }
+        
+        result_cache_statistics
+        statistics() {
+            std::lock_guard<std::mutex> lock(entries_mutex);
+            result_cache_statistics snapshot = counters;
+            snapshot.entries = entries.size();
+            snapshot.bytes = used_bytes;
+            return snapshot;
+        }
+        
+        void
+        reset_statistics() {
+            std::lock_guard<std::mutex> lock(entries_mutex);
+            counters = result_cache_statistics();
+        }
+    };
+    
+    enum class change_op { insert = SQLITE_INSERT, update = SQLITE_UPDATE, remove = SQLITE_DELETE };
+    
+    struct change_event {
+        change_op op;
+        integer rowid;
+        /**
+         *sequence number of the commit the change belongs to, counted per delegate from 1
+         */
+        uint64_t commit;
+    };
+    
+    struct change_feed_options {
+        /**
+         *events buffered for the subscriber, a commit that does not fit is dropped whole
+         */
+        size_t capacity = 65536;
+        /**
+         *read the current row of every insert and update when it is taken from the feed
+         */
+        bool decode_rows = false;
+    };
+    
+    /**
+     *fixed ring of committed change events for one subscriber; the writer only ever appends
+     *whole commits and never waits for room, a commit that does not fit is counted as lost
+     */
+    class change_ring {
+    private:
+        std::vector<change_event> slots;
+        /**
+         *commits dropped just before the commit starting at the same slot
+         */
+        std::vector<size_t> lost_before;
+        size_t head = 0;
+        size_t used = 0;
+        size_t lost = 0;
+        bool closed = false;
+        std::mutex ring_mutex;
+        std::condition_variable ready;
+    public:
+        explicit change_ring(size_t capacity) : slots(std::max<size_t>(capacity, 1)), lost_before(slots.size(), 0) {
+            
+        }
+        
+        change_ring(const change_ring &) = delete;
+        change_ring &operator=(const change_ring &) = delete;
+        
+        void
+        publish(const std::vector<change_event> &events) {
+            {
+                std::lock_guard<std::mutex> lock(ring_mutex);
+                if (closed) {
+                    return;
+                }
+                if (events.empty() || events.size() > slots.size() - used) {
+                    lost += events.empty() ? 0 : 1;
+                    return;
+                }
+                lost_before[(head + used) % slots.size()] = lost;
+                lost = 0;
+                for (const change_event &event : events) {
+                    slots[(head + used) % slots.size()] = event;
+                    used++;
+                }
+            }
+            ready.notify_one();
+        }
+        
+        /**
+         *events of the oldest buffered commit and the number of commits dropped right before it,
+         *false on timeout or once closed and drained
+         */
+        bool
+        pop_commit(std::vector<change_event> &events, size_t &lost_commits, std::chrono::milliseconds timeout) {
+            events.clear();
+            lost_commits = 0;
+            std::unique_lock<std::mutex> lock(ring_mutex);
+            if (!ready.wait_for(lock, timeout, [this] { return used != 0 || closed; }) || used == 0) {
+                return false;
+            }
+            lost_commits = lost_before[head];
+            uint64_t commit = slots[head].commit;
+            while (used != 0 && slots[head].commit == commit) {
+                events.push_back(slots[head]);
+                head = (head + 1) % slots.size();
+                used--;
+            }
+            return true;
+        }
+        
+        void
+        close() {
+            {
+                std::lock_guard<std::mutex> lock(ring_mutex);
+                closed = true;
+            }
+            ready.notify_all();
+        }
+    };
+    
+    /**
+     *subscribers of one delegate, shared with every subscription so either side can go first
+     */
+    class change_registry {
+    private:
+        std::vector<std::shared_ptr<change_ring>> rings;
+        std::atomic<size_t> ring_count;
+        std::mutex rings_mutex;
+    public:
+        change_registry() : ring_count(0) {
+            
+        }
+        
+        size_t
+        size() const {
+            return ring_count.load();
+        }
+        
+        void
+        add(std::shared_ptr<change_ring> ring) {
+            std::lock_guard<std::mutex> lock(rings_mutex);
+            rings.emplace_back(std::move(ring));
+            ring_count.store(rings.size());
+        }
+        
+        void
+        remove(const std::shared_ptr<change_ring> &ring) {
+            std::lock_guard<std::mutex> lock(rings_mutex);
+            rings.erase(std::remove(rings.begin(), rings.end(), ring), rings.end());
+            ring_count.store(rings.size());
+        }
+        
+        void
+        publish(const std::vector<change_event> &events) {
+            std::lock_guard<std::mutex> lock(rings_mutex);
+            for (const std::shared_ptr<change_ring> &ring : rings) {
+                ring->publish(events);
+            }
+        }
+        
+        void
+        close() {
+            std::lock_guard<std::mutex> lock(rings_mutex);
+            for (const std::shared_ptr<change_ring> &ring : rings) {
+                ring->close();
+            }
+            rings.clear();
+            ring_count.store(0);
+        }
+    };
+    
+    /**
+     *committed changes of a delegate's table, one commit per batch in commit order; take batches
+     *from a single thread. Rows are read when the batch is taken, so they show the row as it is
+     *then (a row deleted in the meantime has has_row false), deletes never carry a row
+     */
+    template<typename...T>
+    class change_subscription {
+    public:
+        typedef std::tuple<T...> row_type;
+        
+        struct change {
+            change_op op;
+            integer rowid;
+            bool has_row = false;
+            row_type row;
+        };
+        
+        struct batch {
+            uint64_t commit = 0;
+            /**
+             *commits dropped before this one because the buffer was full, resynchronize if not 0
+             */
+            size_t lost_commits = 0;
+            std::vector<change> changes;
+        };
+    private:
+        std::shared_ptr<change_registry> registry;
+        std::shared_ptr<change_ring> ring;
+        std::vector<change_event> events;
+        sqlite3 *decode_db = nullptr;
+        sqlite3_stmt *decode_stmt = nullptr;
+    public:
+        change_subscription(std::shared_ptr<change_registry> registry, std::shared_ptr<change_ring> ring,
+                            sqlite3 *decode_db, sqlite3_stmt *decode_stmt)
+        : registry(std::move(registry)), ring(std::move(ring)), decode_db(decode_db), decode_stmt(decode_stmt) {
+            
+        }
+        
+        ~change_subscription() {
+            registry->remove(ring);
+            sqlite3_finalize(decode_stmt);
+            if (decode_db) {
+                sqlite3_close(decode_db);
+            }
+        }
+        
+        change_subscription(const change_subscription &) = delete;
+        change_subscription &operator=(const change_subscription &) = delete;
+        
+        /**
+         *waits up to timeout for the next commit; SQLITE_OK with a batch, SQLITE_DONE when none
+         *arrived or the delegate is gone, otherwise the error of reading a row
+         */
+        SQLITE_API int SQLITE_STDCALL
+        next(batch &result, std::chrono::milliseconds timeout) {
+            result.changes.clear();
+            if (!ring->pop_commit(events, result.lost_commits, timeout)) {
+                return SQLITE_DONE;
+            }
+            result.commit = events.front().commit;
+            result.changes.resize(events.size());
+            for (size_t index = 0; index < events.size(); index++) {
+                change &current = result.changes[index];
+                current.op = events[index].op;
+                current.rowid = events[index].rowid;
+                if (decode_stmt == nullptr || current.op == change_op::remove) {
+                    continue;
+                }
+                sqlite3_bind_int64(decode_stmt, 1, current.rowid);
+                SQLITE_API int SQLITE_STDCALL step_err = sqlite3_step(decode_stmt);
+                if (step_err == SQLITE_ROW) {
+                    tuple_utility::get_row(decode_stmt, current.row);
+                    current.has_row = true;
+                    step_err = SQLITE_DONE;
+                }
+                sqlite3_reset(decode_stmt);
+                if (step_err != SQLITE_DONE) {
+                    return step_err;
+                }
+            }
+            return SQLITE_OK;
+        }
+    };
+
+    using Col_Nms_Type = std::vector<std::string>;
+    using Col_Tps_Type = std::vector<std::string>;
+    using Db_Row_Type = std::vector<sqlite3_row::column_info>;
+    
+	template<typename T>
+	void
+	make_column_constraint(Col_Tps_Type& column_constraints, Db_Row_Type& db_row, size_t& column_count, size_t& db_row_size) {
+		throw;
+	}
+    //integer
+    template<>
+    void
+	make_column_constraint<typename sqlite_tool::integer>(Col_Tps_Type& column_constraints, Db_Row_Type& db_row, size_t& column_count, size_t& db_row_size) {
+		column_constraints.emplace_back(std::string("INTEGER DEFAULT 0"));
+		const std::type_info& col_tp = typeid(sqlite_tool::integer);
+		auto&& col_tuple = sqlite3_row::column_info(db_row_size, sizeof(sqlite_tool::integer), column_count, col_tp);
+		db_row.emplace_back(std::move(col_tuple));
+		db_row_size += sizeof(sqlite_tool::integer);
+		column_count++;
+	}
+    //real
+    template<>
+    void
+	make_column_constraint<typename sqlite_tool::real>(Col_Tps_Type& column_constraints, Db_Row_Type& db_row, size_t& column_count, size_t& db_row_size) {
+		column_constraints.emplace_back(std::string("REAL DEFAULT 0.0"));
+		const std::type_info& col_tp = typeid(sqlite_tool::real);
+		auto&& col_tuple = sqlite3_row::column_info(db_row_size, sizeof(sqlite_tool::real), column_count, col_tp);
+		db_row.emplace_back(std::move(col_tuple));
+		db_row_size += sizeof(sqlite_tool::real);
+		column_count++;
+	}
+    //char_string
+    template<>
+    void
+	make_column_constraint<typename sqlite_tool::char_string>(Col_Tps_Type& column_constraints, Db_Row_Type& db_row, size_t& column_count, size_t& db_row_size) {
+		column_constraints.emplace_back(std::string("TEXT DEFAULT \"\""));
+		const std::type_info& col_tp = typeid(sqlite_tool::char_string);
+		auto&& col_tuple = sqlite3_row::column_info(db_row_size, sizeof(sqlite_tool::char_string), column_count, col_tp);
+		db_row.emplace_back(std::move(col_tuple));
+		db_row_size += sizeof(sqlite_tool::char_string);
+		column_count++;
+	}
+    //data_string
+    template<>
+    void
+	make_column_constraint<typename sqlite_tool::data_string>(Col_Tps_Type& column_constraints, Db_Row_Type& db_row, size_t& column_count, size_t& db_row_size) {
+		column_constraints.emplace_back(std::string("BLOB NOT NULL"));
+		const std::type_info& col_tp = typeid(sqlite_tool::data_string);
+		auto&& col_tuple = sqlite3_row::column_info(db_row_size, sizeof(sqlite_tool::data_string), column_count, col_tp);
+		db_row.emplace_back(std::move(col_tuple));
+		db_row_size += sizeof(sqlite_tool::data_string);
+		column_count++;
+	}
+    
+    template<typename...COLUMN_TYPE>
+    class sqlite3_delegate {        
+    private:
+        template <typename...T>
+        using tp_type = std::tuple<T...>;
+        typedef tp_type<COLUMN_TYPE...> full_tuple_type;
+        
+        /**
+         *member variables
+         */
+        sqlite_tool::Col_Nms_Type columns;
+        sqlite_tool::Col_Tps_Type column_constraints;
+        std::string db_file;
+        sqlite_tool::open_options options;
+        std::string table;
+        struct sqlite3 *sqdb = nullptr;
+        size_t db_row_size = 0;
+        size_t column_count = 0;
+        sqlite_tool::Db_Row_Type db_row;
+        
+        std::string execute_conditions;
+        std::vector<sqlite_tool::bound_value> condition_values;
+        sqlite_tool::stmt_cache statements;
+        sqlite_tool::reader_pool readers;
+        std::unique_ptr<sqlite_tool::async_writer> writer;
+        std::unique_ptr<sqlite_tool::query_executor> executor;
+        std::unique_ptr<sqlite_tool::memory_flusher> flusher;
+        std::unique_ptr<sqlite_tool::result_cache> cache;
+        std::atomic<bool> table_changed;
+        std::shared_ptr<sqlite_tool::change_registry> feed;
+        /**
+         *changes of the open transaction, and of a commit not yet known to have succeeded
+         */
+        std::vector<sqlite_tool::change_event> pending_changes;
+        std::vector<sqlite_tool::change_event> committed_changes;
+        uint64_t commit_sequence = 0;
+        bool wal_journal = false;
+        sqlite_tool::statistics_sink instrumentation;
+        std::vector<sqlite_tool::index_definition> indexes;
+    private:
+        void 
+        push_col_name(std::vector<std::string> &columns, std::string &&column) {
+            columns.push_back(column);
+        }
+        
+        template<typename FT, typename ST, typename...RT>
+        void 
+        push_col_name(std::vector<std::string> &columns, FT &&first, ST &&second, RT &&...rest) {
+            push_col_name(columns, std::forward<FT>(first));
+            push_col_name(columns, std::forward<ST>(second), std::forward<RT>(rest)...);
+        }
+        
+        template<typename T>
+        void
+        init_column_constraints() {
+			make_column_constraint<T>(column_constraints, db_row, column_count, db_row_size);
+        }
+        
+        template<typename T1, typename T2, typename...Tn>
+        void
+        init_column_constraints() {
+            init_column_constraints<T1>();
+            init_column_constraints<T2, Tn...>();
+        }
+        
+    public:
+        
+        sqlite3_delegate() : table_changed(false) {
+            init_column_constraints<COLUMN_TYPE...>();
+        }
+        
+        ~sqlite3_delegate() {
+            executor.reset();
+            writer.reset();
+            flusher.reset();
+            cache.reset();
+            if (feed) {
+                feed->close();
+            }
+            readers.close();
+            statements.clear();
+            if (sqdb) {
+                sqlite3_close(sqdb);
+                sqdb = nullptr;
+            }
+        }
+        
+        void set_db_file_path(std::string db) {
+            db_file = std::move(db);
+        }
+        
+        void set_db_file_path(std::string db, const sqlite_tool::open_options &options) {
+            db_file = std::move(db);
+            this->options = options;
+        }
+        
+        void set_table_name(std::string table) {
+            this->table = std::move(table);
+        }
+        
+        template<typename...T>
+        void
+        set_column_names(T...t) {
+            if (sizeof...(COLUMN_TYPE) != sizeof...(T)) {
+                throw;
+            }
+            columns.clear();
+            push_col_name(columns, std::forward<T>(t)...);
+        }
+
+    private:
+        void
+        push_column_constraint(std::string constraint) {
+            column_constraints.emplace_back(constraint);
+        }
+
+        template<typename T0, typename T1, typename...T>
+        void 
+        push_column_constraint(T0 t0, T1 t1, T...t) {
+            push_column_constraint(std::forward<T0>(t0));
+            push_column_constraint(std::forward<T1>(t1), std::forward<T>(t)...);
+        }
+    public:
+        template<typename...T>
+        void
+        set_column_constraints(T...t) {
+            if (sizeof...(COLUMN_TYPE) != sizeof...(T)) {
+                throw;
+            }
+            column_constraints.clear();
+            push_column_constraint(std::forward<T>(t)...);
+        }
+        
+        /**
+         *totals per operation type since the delegate was created or reset_statistics,
+         *all zero unless compiled with SQLXX_INSTRUMENTATION=1
+         */
+        sqlite_tool::delegate_statistics
+        get_statistics() {
+            return instrumentation.snapshot();
+        }
+        
+        void
+        reset_statistics() {
+            instrumentation.reset();
+        }
+        
+        /**
+         *called after every measured operation with that call's numbers, from the calling thread
+         */
+        void
+        set_statistics_callback(sqlite_tool::statistics_callback callback) {
+            instrumentation.set_callback(std::move(callback));
+        }
+        
+    private:
+        /**
+         *hooks of the delegate's connection, run on the writing thread while SQLite holds the connection;
+         *a change marks the table and is queued for subscribers, both are settled when the transaction ends
+         */
+        static void
+        update_hook(void *context, int op, const char *, const char *table_name, sqlite3_int64 rowid) {
+            sqlite3_delegate *self = reinterpret_cast<sqlite3_delegate *>(context);
+            if (sqlite3_stricmp(table_name, self->table.c_str()) != 0) {
+                return;
+            }
+            self->table_changed.store(true);
+            if (self->cache) {
+                self->cache->invalidate();
+            }
+            if (self->feed && self->feed->size() != 0) {
+                sqlite_tool::change_event event;
+                event.op = sqlite_tool::change_op(op);
+                event.rowid = rowid;
+                event.commit = 0;
+                self->pending_changes.push_back(event);
+            }
+        }
+        
+        /**
+         *the commit can still fail after this hook (SQLITE_BUSY while readers hold the file), so its
+         *changes are only staged; a retried COMMIT stages what changed since behind them
+         */
+        static int
+        commit_hook(void *context) {
+            sqlite3_delegate *self = reinterpret_cast<sqlite3_delegate *>(context);
+            self->committed_changes.insert(self->committed_changes.end(), self->pending_changes.begin(), self->pending_changes.end());
+            self->pending_changes.clear();
+            return 0;
+        }
+        
+        void
+        publish_committed_changes() {
+            if (committed_changes.empty()) {
+                return;
+            }
+            commit_sequence++;
+            for (sqlite_tool::change_event &event : committed_changes) {
+                event.commit = commit_sequence;
+            }
+            feed->publish(committed_changes);
+            committed_changes.clear();
+        }
+        
+        /**
+         *call on the writing thread after a statement that may have committed: in WAL mode the WAL hook
+         *already published a commit that happened, otherwise it is published here once the connection
+         *is back in autocommit; a failed implicit commit is rolled back and its staged changes dropped,
+         *a failed COMMIT leaves the transaction open and keeps them for the retry
+         */
+        void
+        settle_changes(int err) {
+            if (sqdb == nullptr || committed_changes.empty() || !sqlite3_get_autocommit(sqdb)) {
+                return;
+            }
+            if (err != SQLITE_OK && err != SQLITE_DONE) {
+                committed_changes.clear();
+            }
+            else if (!wal_journal) {
+                publish_committed_changes();
+            }
+        }
+        
+        /**
+         *ROLLBACK TO and a failed statement undo rows without calling rollback_hook,
+         *their queued changes are dropped here instead; call on the writing thread
+         */
+        void
+        discard_changes_since(size_t mark) {
+            if (pending_changes.size() > mark) {
+                pending_changes.resize(mark);
+            }
+        }
+        
+        static void
+        rollback_hook(void *context) {
+            sqlite3_delegate *self = reinterpret_cast<sqlite3_delegate *>(context);
+            if (self->table_changed.exchange(false) && self->cache) {
+                self->cache->invalidate();
+            }
+            self->pending_changes.clear();
+            self->committed_changes.clear();
+        }
+        
+        /**
+         *runs after a commit in WAL mode, when readers of the pool can first see it; replaces
+         *SQLite's automatic checkpoint hook, so checkpoint the same way (every 1000 pages)
+         */
+        static int
+        wal_hook(void *context, sqlite3 *db, const char *database, int pages) {
+            sqlite3_delegate *self = reinterpret_cast<sqlite3_delegate *>(context);
+            if (self->table_changed.exchange(false) && self->cache) {
+                self->cache->invalidate();
+            }
+            self->publish_committed_changes();
+            if (pages >= 1000) {
+                sqlite3_wal_checkpoint(db, database);
+            }
+            return SQLITE_OK;
+        }
+        
+        SQLITE_API int SQLITE_STDCALL
+        install_hooks() {
+            if (sqdb == nullptr) {
+                SQLITE_API int SQLITE_STDCALL open_err = open_db();
+                if (open_err != SQLITE_OK) {
+                    return open_err;
+                }
+            }
+            std::string journal_mode;
+            SQLITE_API int SQLITE_STDCALL journal_err = sqlite3_exec(sqdb, "PRAGMA journal_mode", [](void *mode, int, char **values, char **) -> int {
+                if (values[0] != nullptr) {
+                    reinterpret_cast<std::string *>(mode)->assign(values[0]);
+                }
+                return 0;
+            }, &journal_mode, NULL);
+            if (journal_err != SQLITE_OK) {
+                return journal_err;
+            }
+            wal_journal = journal_mode == "wal";
+            sqlite3_update_hook(sqdb, &sqlite3_delegate::update_hook, this);
+            sqlite3_commit_hook(sqdb, &sqlite3_delegate::commit_hook, this);
+            sqlite3_rollback_hook(sqdb, &sqlite3_delegate::rollback_hook, this);
+            sqlite3_wal_hook(sqdb, &sqlite3_delegate::wal_hook, this);
+            return SQLITE_OK;
+        }
+        
+    public:
+        /**
+         *results of get_column_value and get_column_value_match_conditions are kept up to max_bytes
+         *(0 disables) keyed by the selected columns and the condition with its values; a write to
+         *the table through this delegate's connection, and a commit by any other connection, empties
+         *the cache. Enable before the delegate is shared between threads; setting PRAGMA
+         *wal_autocheckpoint afterwards replaces the commit hook pooled readers rely on
+         */
+        SQLITE_API int SQLITE_STDCALL
+        enable_result_cache(size_t max_bytes) {
+            cache.reset();
+            if (max_bytes == 0) {
+                return SQLITE_OK;
+            }
+            SQLITE_API int SQLITE_STDCALL err = install_hooks();
+            if (err != SQLITE_OK) {
+                return err;
+            }
+            std::unique_ptr<sqlite_tool::result_cache> result_cache(new sqlite_tool::result_cache(max_bytes));
+            /**
+             *no other connection can write a :memory: database or the working set of memory mode
+             */
+            if (!flusher && !db_file.empty() && db_file != ":memory:") {
+                err = result_cache->attach(db_file, options);
+                if (err != SQLITE_OK) {
+                    return err;
+                }
+            }
+            cache = std::move(result_cache);
+            return SQLITE_OK;
+        }
+        
+        sqlite_tool::result_cache_statistics
+        get_result_cache_statistics() {
+            return cache ? cache->statistics() : sqlite_tool::result_cache_statistics();
+        }
+        
+        void
+        reset_result_cache_statistics() {
+            if (cache) {
+                cache->reset_statistics();
+            }
+        }
+        
+        void
+        clear_result_cache() {
+            if (cache) {
+                cache->invalidate();
+            }
+        }
+        
+        /**
+         *committed inserts, updates and deletes of the table written through this delegate's connection;
+         *the writer never waits for a subscriber, commits that overflow its buffer are reported as lost.
+         *decode_rows reads rows over a read only connection of its own, so it needs a database file
+         *and is not available in memory mode; subscribe before the delegate is shared between threads
+         */
+        SQLITE_API int SQLITE_STDCALL
+        subscribe_changes(std::unique_ptr<sqlite_tool::change_subscription<COLUMN_TYPE...>> &subscription,
+                          const sqlite_tool::change_feed_options &feed_options = sqlite_tool::change_feed_options()) {
+            subscription.reset();
+            if (feed_options.decode_rows && (flusher || db_file.empty() || db_file == ":memory:")) {
+                return SQLITE_MISUSE;
+            }
+            SQLITE_API int SQLITE_STDCALL err = install_hooks();
+            if (err != SQLITE_OK) {
+                return err;
+            }
+            
+            sqlite3 *decode_db = nullptr;
+            sqlite3_stmt *decode_stmt = nullptr;
+            if (feed_options.decode_rows) {
+                err = sqlite3_open_v2(db_file.c_str(), &decode_db, SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX, NULL);
+                if (err == SQLITE_OK) {
+                    err = options.apply(decode_db, true);
+                }
+                if (err == SQLITE_OK && options.busy_timeout < 0) {
+                    err = sqlite3_busy_timeout(decode_db, 5000);
+                }
+                if (err == SQLITE_OK) {
+                    std::string sqlcmd("SELECT ");
+                    for (size_t index = 0; index < columns.size(); index++) {
+                        if (index != 0) {
+                            sqlcmd.append(",");
+                        }
+                        sqlcmd.append(columns.at(index));
+                    }
+                    sqlcmd.append(" FROM ");
+                    sqlcmd.append(table);
+                    sqlcmd.append(" WHERE rowid = ?");
+                    err = sqlite3_prepare_v2(decode_db, sqlcmd.c_str(), -1, &decode_stmt, NULL);
+                }
+                if (err != SQLITE_OK) {
+                    sqlite3_close(decode_db);
+                    return err;
+                }
+            }
+            
+            if (!feed) {
+                feed = std::make_shared<sqlite_tool::change_registry>();
+            }
+            std::shared_ptr<sqlite_tool::change_ring> ring = std::make_shared<sqlite_tool::change_ring>(feed_options.capacity);
+            feed->add(ring);
+            subscription.reset(new sqlite_tool::change_subscription<COLUMN_TYPE...>(feed, ring, decode_db, decode_stmt));
+            return SQLITE_OK;
+        }
+        
+        /**
+         *maximum number of prepared statements kept for reuse, 0 disables caching
+         */
+        void
+        set_statement_cache_capacity(size_t capacity) {
+            statements.set_capacity(capacity);
+        }
+        
+        template<std::size_t index>
+        void
+        add_column_constraint(std::string constraint) {
+//            std::swap(column_constraints.at(index), constraint);
+            column_constraints.at(index).append(" ");
+            column_constraints.at(index).append(constraint);
+        }
+
+        template<std::size_t index>
+        void 
+        set_column_constraint(std::string constraint) {
+            column_constraints.at(index) = constraint;
+        }
+        
+    private:
+        template<size_t...col_x>
+        struct valid_columns {
+            static const bool value = true;
+        };
+        
+        template<size_t first, size_t...rest>
+        struct valid_columns<first, rest...> {
+            static const bool value = first < sizeof...(COLUMN_TYPE) && valid_columns<rest...>::value;
+        };
+        
+        template<size_t...col_x>
+        void
+        push_index(std::string name, bool unique, const sqlite_tool::sqlite3_condition &where) {
+            static_assert(sizeof...(col_x) > 0, "an index needs at least one column");
+            static_assert(valid_columns<col_x...>::value, "index column out of range");
+            sqlite_tool::index_definition definition;
+            definition.name = std::move(name);
+            definition.columns = {col_x...};
+            definition.unique = unique;
+            definition.where = where;
+            indexes.emplace_back(std::move(definition));
+        }
+        
+    public:
+        /**
+         *secondary index on columns col_x... in that order, created by create_table_if_not_exists
+         *(or create_indexes); an empty name becomes <table>_<column>_..._idx
+         */
+        template<size_t...col_x>
+        void
+        add_index(std::string name = std::string()) {
+            push_index<col_x...>(std::move(name), false, sqlite_tool::sqlite3_condition());
+        }
+        
+        template<size_t...col_x>
+        void
+        add_unique_index(std::string name = std::string()) {
+            push_index<col_x...>(std::move(name), true, sqlite_tool::sqlite3_condition());
+        }
+        
+        /**
+         *only rows matching where are indexed, its values are written into the index sql as literals
+         */
+        template<size_t...col_x>
+        void
+        add_partial_index(const sqlite_tool::sqlite3_condition &where, std::string name = std::string(), bool unique = false) {
+            push_index<col_x...>(std::move(name), unique, where);
+        }
+
+    private:
+        SQLITE_API int SQLITE_STDCALL
+        open_connection(int flags) {
+            SQLITE_API int SQLITE_STDCALL open_err = SQLITE_OK;
+            if (flags != 0) {
+                open_err = sqlite3_open_v2(db_file.c_str(), &sqdb, flags, NULL);
+            }
+            else {
+                open_err = sqlite3_open(db_file.c_str(), &sqdb);
+            }
+            if (open_err != SQLITE_OK) {
+                return open_err;
+            }
+            return options.apply(sqdb);
+        }
+        
+    public:
+        /**
+         *settings applied right after the connection is opened (applied at once if it is already open)
+         */
+        SQLITE_API int SQLITE_STDCALL
+        set_open_options(const sqlite_tool::open_options &options) {
+            this->options = options;
+            if (sqdb != nullptr) {
+                return options.apply(sqdb);
+            }
+            return SQLITE_OK;
+        }
+        
+        /**
+         *the settings actually in effect on the delegate's connection
+         */
+        SQLITE_API int SQLITE_STDCALL
+        get_open_options(sqlite_tool::open_options &effective) {
+            if (sqdb == nullptr) {
+                SQLITE_API int SQLITE_STDCALL open_err = open_db();
+                if (open_err != SQLITE_OK) {
+                    return open_err;
+                }
+            }
+            SQLITE_API int SQLITE_STDCALL err = sqlite_tool::open_options::query(sqdb, effective);
+            effective.flags = options.flags;
+            return err;
+        }
+        
+        SQLITE_API int SQLITE_STDCALL 
+        open_db() {
+            //return sqlite3_open_v2(db_file.c_str(), &sqdb, SQLITE_OPEN_READWRITE, NULL);
+			return open_connection(options.flags);
+        }
+        
+        SQLITE_API int SQLITE_STDCALL
+        create_table_if_not_exists() {
+			auto err = SQLXX_FILE_ACCESS(db_file.c_str(), 00);
+            if (err == SQLXX_FILE_ENOENT && db_file != ":memory:" && !db_file.empty()) {
+                SQLXX_FILE_CREATE(db_file.c_str(), "a");
+            }
+            
+            std::string sqlcmd("CREATE TABLE IF NOT EXISTS ");
+            sqlcmd.append(table);
+            sqlcmd.append("(");
+            for (size_t index = 0; index < columns.size(); index++) {
+                const std::string &name = columns.at(index);
+                const std::string &type = column_constraints.at(index);
+                sqlcmd.append(name);
+                sqlcmd.append(" ");
+                sqlcmd.append(type);
+                if (name != columns.back()) {
+                    sqlcmd.append(",");
+                }
+            }
+            sqlcmd.append(")");
+            
+            if (sqdb == nullptr) {
+                SQLITE_API int SQLITE_STDCALL open_err = open_db();
+                if (open_err != SQLITE_OK) {
+                    return open_err;
+                }
+            }
+
+            sqlite3_stmt *stmt = nullptr;
+            SQLITE_API int SQLITE_STDCALL prep_err = sqlite3_prepare_v2(sqdb, sqlcmd.c_str(), int(-1), &stmt, NULL);
+            if (prep_err != SQLITE_OK) {
+                return prep_err;
+            }
+            
+            SQLITE_API int SQLITE_STDCALL step_err = sqlite3_step(stmt);
+            sqlite3_finalize(stmt);
+            if (step_err != SQLITE_DONE) {
+                return step_err;
+            }
+            
+            return create_indexes();
+        }
+        
+        /**
+         *CREATE INDEX IF NOT EXISTS for every declared index, called by create_table_if_not_exists
+         */
+        SQLITE_API int SQLITE_STDCALL
+        create_indexes() {
+            for (const sqlite_tool::index_definition &definition : indexes) {
+                std::string name(definition.name);
+                if (name.empty()) {
+                    name = table;
+                    for (size_t column : definition.columns) {
+                        name.append("_");
+                        name.append(columns.at(column));
+                    }
+                    name.append("_idx");
+                }
+                std::string sqlcmd(definition.unique ? "CREATE UNIQUE INDEX IF NOT EXISTS " : "CREATE INDEX IF NOT EXISTS ");
+                sqlcmd.append(name);
+                sqlcmd.append(" ON ");
+                sqlcmd.append(table);
+                sqlcmd.append("(");
+                for (size_t index = 0; index < definition.columns.size(); index++) {
+                    if (index != 0) {
+                        sqlcmd.append(",");
+                    }
+                    sqlcmd.append(columns.at(definition.columns[index]));
+                }
+                sqlcmd.append(")");
+                if (!definition.where.empty()) {
+                    sqlcmd.append(" WHERE ");
+                    sqlcmd.append(definition.where.render_literal(columns));
+                }
+                SQLITE_API int SQLITE_STDCALL err = execute_sql(sqlcmd.c_str());
+                if (err != SQLITE_OK) {
+                    return err;
+                }
+            }
+            return SQLITE_OK;
+        }
+        
+        /**
+         *pooled mode: the delegate's connection becomes the only writer and is switched to WAL,
+         *query methods then run on one of reader_count read-only connections, so reads from
+         *several threads proceed in parallel and are not blocked by a write in progress;
+         *call after create_table_if_not_exists, the database must be a file
+         */
+        SQLITE_API int SQLITE_STDCALL
+        open_reader_pool(size_t reader_count) {
+            if (flusher) {
+                return SQLITE_MISUSE;
+            }
+            if (sqdb == nullptr) {
+                SQLITE_API int SQLITE_STDCALL open_err = open_connection(SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_NOMUTEX);
+                if (open_err != SQLITE_OK) {
+                    return open_err;
+                }
+            }
+            
+            std::string journal_mode;
+            SQLITE_API int SQLITE_STDCALL wal_err = sqlite3_exec(sqdb, "PRAGMA journal_mode=WAL", [](void *mode, int, char **values, char **) -> int {
+                if (values[0] != nullptr) {
+                    reinterpret_cast<std::string *>(mode)->assign(values[0]);
+                }
+                return 0;
+            }, &journal_mode, NULL);
+            if (wal_err != SQLITE_OK) {
+                return wal_err;
+            }
+            if (journal_mode != "wal") {
+                return SQLITE_ERROR;
+            }
+            wal_journal = true;
+            
+            return readers.open(db_file, reader_count, options);
+        }
+        
+        void
+        close_reader_pool() {
+            readers.close();
+        }
+        
+        /**
+         *memory mode: call instead of open_db (before create_table_if_not_exists); the database file
+         *is loaded into a :memory: connection that every read and write then uses, and a background
+         *thread copies committed changes back to the file every mode.flush_interval (retrying while a
+         *transaction is open, see memory_mode_options) and once more when the delegate is destroyed;
+         *reader pools are not available in this mode
+         */
+        SQLITE_API int SQLITE_STDCALL
+        open_in_memory(const sqlite_tool::memory_mode_options &mode = sqlite_tool::memory_mode_options()) {
+            if (sqdb != nullptr || db_file.empty() || db_file == ":memory:") {
+                return SQLITE_MISUSE;
+            }
+            SQLITE_API int SQLITE_STDCALL err = sqlite3_open_v2(":memory:", &sqdb, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_FULLMUTEX, NULL);
+            if (err == SQLITE_OK) {
+                err = options.apply(sqdb);
+            }
+            std::unique_ptr<sqlite_tool::memory_flusher> memory_flusher(new sqlite_tool::memory_flusher());
+            if (err == SQLITE_OK) {
+                err = memory_flusher->start(sqdb, db_file, mode);
+            }
+            if (err != SQLITE_OK) {
+                sqlite3_close(sqdb);
+                sqdb = nullptr;
+                return err;
+            }
+            flusher = std::move(memory_flusher);
+            return SQLITE_OK;
+        }
+        
+        /**
+         *memory mode: write committed changes to the file now, SQLITE_BUSY inside a transaction
+         */
+        SQLITE_API int SQLITE_STDCALL
+        flush() {
+            if (!flusher) {
+                return SQLITE_MISUSE;
+            }
+            return flusher->flush();
+        }
+        
+        /**
+         *memory mode: result of the last timed flush
+         */
+        SQLITE_API int SQLITE_STDCALL
+        flush_error() const {
+            return flusher ? flusher->error() : SQLITE_OK;
+        }
+        
+        /**
+         *online backup of the delegate's database into the file at path (replacing its content);
+         *writes made through the delegate between steps are carried into the copy, writes from
+         *other connections restart it, so the finished copy is always a consistent snapshot
+         */
+        SQLITE_API int SQLITE_STDCALL
+        backup_to_file(const std::string &path, const sqlite_tool::backup_options &options = sqlite_tool::backup_options()) {
+            if (sqdb == nullptr) {
+                SQLITE_API int SQLITE_STDCALL open_err = open_db();
+                if (open_err != SQLITE_OK) {
+                    return open_err;
+                }
+            }
+            sqlite3 *target = nullptr;
+            SQLITE_API int SQLITE_STDCALL err = sqlite3_open(path.c_str(), &target);
+            if (err == SQLITE_OK) {
+                err = sqlite_tool::backup_utility::backup(target, sqdb, options);
+            }
+            sqlite3_close(target);
+            return err;
+        }
+        
+        /**
+         *replaces the delegate's database with the content of the file at path; do not run
+         *this while an async writer is started, pooled readers see the result once it returns
+         */
+        SQLITE_API int SQLITE_STDCALL
+        restore_from_file(const std::string &path, const sqlite_tool::backup_options &options = sqlite_tool::backup_options()) {
+            if (sqdb == nullptr) {
+                SQLITE_API int SQLITE_STDCALL open_err = open_db();
+                if (open_err != SQLITE_OK) {
+                    return open_err;
+                }
+            }
+            sqlite3 *source = nullptr;
+            SQLITE_API int SQLITE_STDCALL err = sqlite3_open_v2(path.c_str(), &source, SQLITE_OPEN_READONLY, NULL);
+            if (err == SQLITE_OK) {
+                err = sqlite_tool::backup_utility::backup(sqdb, source, options);
+                restored();
+            }
+            sqlite3_close(source);
+            return err;
+        }
+        
+        /**
+         *consistent copy of the delegate's database in memory, opened on first use
+         */
+        SQLITE_API int SQLITE_STDCALL
+        snapshot_to_memory(sqlite_tool::memory_database &snapshot, const sqlite_tool::backup_options &options = sqlite_tool::backup_options()) {
+            if (sqdb == nullptr) {
+                SQLITE_API int SQLITE_STDCALL open_err = open_db();
+                if (open_err != SQLITE_OK) {
+                    return open_err;
+                }
+            }
+            SQLITE_API int SQLITE_STDCALL err = snapshot.open();
+            if (err != SQLITE_OK) {
+                return err;
+            }
+            return sqlite_tool::backup_utility::backup(snapshot.handle(), sqdb, options);
+        }
+        
+        /**
+         *puts a snapshot taken by snapshot_to_memory back, same rules as restore_from_file
+         */
+        SQLITE_API int SQLITE_STDCALL
+        restore_from_memory(const sqlite_tool::memory_database &snapshot, const sqlite_tool::backup_options &options = sqlite_tool::backup_options()) {
+            if (snapshot.handle() == nullptr) {
+                return SQLITE_MISUSE;
+            }
+            if (sqdb == nullptr) {
+                SQLITE_API int SQLITE_STDCALL open_err = open_db();
+                if (open_err != SQLITE_OK) {
+                    return open_err;
+                }
+            }
+            SQLITE_API int SQLITE_STDCALL err = sqlite_tool::backup_utility::backup(sqdb, snapshot.handle(), options);
+            restored();
+            return err;
+        }
+        
+    private:
+        /**
+         *a backup into the delegate's connection fires no update hook and leaves its data_version alone
+         */
+        void
+        restored() {
+            if (cache) {
+                cache->invalidate();
+            }
+        }
+        
+
+        connection_lease
+        lease_reader() {
+            if (readers.size() != 0) {
+                return connection_lease(&readers);
+            }
+            SQLITE_API int SQLITE_STDCALL open_err = SQLITE_OK;
+            if (sqdb == nullptr) {
+                open_err = open_db();
+            }
+            return connection_lease(sqdb, &statements, open_err);
+        }
+        
+        SQLITE_API int SQLITE_STDCALL
+        prepare_statement(const std::string &sqlcmd, sqlite3_stmt **stmt, bool *prepared = nullptr) {
+            if (sqdb == nullptr) {
+                SQLITE_API int SQLITE_STDCALL open_err = open_db();
+                if (open_err != SQLITE_OK) {
+                    return open_err;
+                }
+            }
+            return statements.acquire(sqdb, sqlcmd, stmt, prepared);
+        }
+        
+    private:
+        template<typename VALUE>
+        void
+        insert_command_prepare_name(std::string &sqlcmd, const std::pair<std::string, VALUE> &column_value_pair) {
+            sqlcmd.append(column_value_pair.first);
+        }
+        
+        template<typename VALUE>
+        void
+        insert_command_prepare_name(std::string &sqlcmd, const std::pair<size_t, VALUE> &column_value_pair) {
+            const std::string &column = columns.at(column_value_pair.first);
+            sqlcmd.append(column);
+        }
+        
+        template<typename FT, typename ST, typename...RT>
+        void
+        insert_command_prepare_name(std::string &sqlcmd, FT &&first, ST &&second, RT &&...rest) {
+            insert_command_prepare_name(sqlcmd, std::forward<FT>(first));
+            sqlcmd.append(",");
+            insert_command_prepare_name(sqlcmd, std::forward<ST>(second), std::forward<RT>(rest)...);
+        }
+        
+        template<typename T>
+        void
+        insert_command_prepare_value(std::string &sqlcmd, const std::pair<std::string, T> &column_value_pair) {
+            sqlcmd.append("$");
+            sqlcmd.append(column_value_pair.first);
+        }
+        
+        template<typename VALUE>
+        void
+        insert_command_prepare_value(std::string &sqlcmd, const std::pair<size_t, VALUE> &column_value_pair) {
+            sqlcmd.append("?");
+        }
+        
+        template<typename FT, typename ST, typename...RT>
+        void
+        insert_command_prepare_value(std::string &sqlcmd, FT &&first, ST &&second, RT &&...rest) {
+            insert_command_prepare_value(sqlcmd, std::forward<FT>(first));
+            sqlcmd.append(",");
+            insert_command_prepare_value(sqlcmd, std::forward<ST>(second), std::forward<RT>(rest)...);
+        }
+        
+    private:
+        template<typename T>
+        std::pair<std::string, T>
+        bind_column_index_transfer_to_name(const std::pair<size_t, T> &pair) {
+            return std::make_pair(columns.at(pair.first), pair.second);
+        }
+        
+        template<typename T>
+        std::pair<std::string, T>
+        bind_column_index_transfer_to_name(const std::pair<std::string, T> &pair) {
+            return pair;
+        }
+        
+        template<typename T>
+        std::pair<size_t, T>
+        bind_column_index_transfer(const std::pair<size_t, T> &pair, size_t &index) {
+            return std::make_pair(index++, pair.second);
+        }
+        
+        template<typename T>
+        std::pair<size_t, T>
+        bind_column_index_transfer(const std::pair<std::string, T> &pair, size_t &index) {
+            return std::make_pair(index++, pair.second);
+        }
+
+    public:
+        template<typename COLTP, typename...VALTP>
+        SQLITE_API int SQLITE_STDCALL
+        put_row(std::pair<COLTP, VALTP>...pair) {
+            sqlite_tool::operation_probe probe(instrumentation, sqlite_tool::operation_type::put_row);
+            size_t parameters = sizeof...(VALTP);
+            if (parameters > std::tuple_size<full_tuple_type>::value) {
+                return SQLITE_ERROR;
+            }
+            
+            std::string sqlcmd("INSERT INTO ");
+            sqlcmd.append(table);
+            sqlcmd.append("(");
+            insert_command_prepare_name(sqlcmd, pair...);
+            sqlcmd.append(") VALUES(");
+            //insert_command_prepare_value(sqlcmd, std::forward<std::pair<COLTP, VALTP>>(pair)...);
+            insert_command_prepare_value(sqlcmd, bind_column_index_transfer_to_name(pair)...);
+            sqlcmd.append(")");
+            
+            sqlite3_stmt *stmt = nullptr;
+            bool prepared = false;
+            probe.start();
+            SQLITE_API int SQLITE_STDCALL prep_err = prepare_statement(sqlcmd, &stmt, &prepared);
+            probe.prepared(prepared);
+            if (prep_err != SQLITE_OK) {
+                return prep_err;
+            }
+            
+            probe.start();
+            SQLITE_API int SQLITE_STDCALL bind_err = bind_utility::bind_value(stmt, bind_column_index_transfer_to_name(pair)...);
+            probe.bound();
+            if (bind_err != SQLITE_OK) {
+                statements.release(stmt);
+                return bind_err;
+            }
+            
+            probe.start();
+            SQLITE_API int SQLITE_STDCALL step_err = sqlite3_step(stmt);
+            probe.stepped(step_err);
+            probe.statement(stmt);
+            statements.release(stmt);
+            settle_changes(step_err);
+            if (step_err != SQLITE_DONE) {
+                return step_err;
+            }
+            
+            return SQLITE_OK;
+        }
+        
+        /**
+         *rowid of the row last inserted through the delegate's connection
+         */
+        sqlite_tool::integer
+        last_insert_rowid() {
+            return sqdb == nullptr ? 0 : sqlite3_last_insert_rowid(sqdb);
+        }
+        
+        /**
+         *incremental I/O on column col_x of row rowid over the delegate's connection; to store a large
+         *value without holding it in memory, insert it as std::make_pair(col_x, sqlite_tool::zero_blob(bytes)),
+         *then open the row writable and write it in chunks. Close the stream before the delegate
+         */
+        template<size_t col_x>
+        SQLITE_API int SQLITE_STDCALL
+        open_blob(sqlite_tool::blob_stream &stream, sqlite_tool::integer rowid, bool writable = false) {
+            typedef typename std::tuple_element<col_x, full_tuple_type>::type column_type;
+            static_assert(std::is_same<column_type, sqlite_tool::data_string>::value || std::is_same<column_type, sqlite_tool::char_string>::value,
+                          "open_blob streams BLOB or TEXT columns");
+            if (sqdb == nullptr) {
+                SQLITE_API int SQLITE_STDCALL open_err = open_db();
+                if (open_err != SQLITE_OK) {
+                    return open_err;
+                }
+            }
+            return stream.open(sqdb, table, columns.at(col_x), rowid, writable);
+        }
+        
+        /**
+         *column col_x of every row matching condition, in rowid order, read chunk_bytes at a time into
+         *one buffer through one reused handle: visitor(rowid, offset, data, bytes, value_size) sees each
+         *chunk (an empty or NULL value once with bytes 0) and returns false to stop
+         */
+        template<size_t col_x, typename VISITOR>
+        SQLITE_API int SQLITE_STDCALL
+        read_blobs_match_conditions(const sqlite_tool::sqlite3_condition &condition, size_t chunk_bytes, VISITOR &&visitor) {
+            std::string sqlcmd("SELECT rowid,");
+            sqlcmd.append(columns.at(col_x));
+            sqlcmd.append(" IS NULL FROM ");
+            sqlcmd.append(table);
+            sqlcmd.append(" WHERE ");
+            sqlcmd.append(condition.render(columns));
+            sqlcmd.append(" ORDER BY rowid");
+            
+            sqlite3_stmt *stmt = nullptr;
+            SQLITE_API int SQLITE_STDCALL prep_err = prepare_statement(sqlcmd, &stmt);
+            if (prep_err != SQLITE_OK) {
+                return prep_err;
+            }
+            SQLITE_API int SQLITE_STDCALL err = bind_condition_values(stmt, condition.parameters());
+            
+            std::vector<sqlite_tool::any_mem_t> buffer(std::max<size_t>(chunk_bytes, 1));
+            sqlite_tool::blob_stream stream;
+            bool stopped = false;
+            while (err == SQLITE_OK && !stopped && (err = sqlite3_step(stmt)) == SQLITE_ROW) {
+                sqlite_tool::integer rowid = sqlite3_column_int64(stmt, 0);
+                /**
+                 *a blob handle cannot open a NULL value
+                 */
+                if (sqlite3_column_int(stmt, 1) != 0) {
+                    stopped = !visitor(rowid, size_t(0), static_cast<const sqlite_tool::any_mem_t *>(buffer.data()), size_t(0), size_t(0));
+                    err = SQLITE_OK;
+                    continue;
+                }
+                err = stream.is_open() ? stream.reopen(rowid) : open_blob<col_x>(stream, rowid);
+                if (err != SQLITE_OK) {
+                    break;
+                }
+                size_t offset = 0;
+                do {
+                    size_t bytes = std::min(buffer.size(), stream.size() - offset);
+                    err = stream.read(buffer.data(), bytes, offset);
+                    if (err != SQLITE_OK) {
+                        break;
+                    }
+                    if (!visitor(rowid, offset, static_cast<const sqlite_tool::any_mem_t *>(buffer.data()), bytes, stream.size())) {
+                        stopped = true;
+                        break;
+                    }
+                    offset += bytes;
+                } while (offset < stream.size());
+            }
+            stream.close();
+            statements.release(stmt);
+            if (err == SQLITE_DONE || err == SQLITE_ROW) {
+                return SQLITE_OK;
+            }
+            return err;
+        }
+        
+    private:
+        SQLITE_API int SQLITE_STDCALL
+        execute_sql(const char *sqlcmd) {
+            if (sqdb == nullptr) {
+                SQLITE_API int SQLITE_STDCALL open_err = open_db();
+                if (open_err != SQLITE_OK) {
+                    return open_err;
+                }
+            }
+            SQLITE_API int SQLITE_STDCALL err = sqlite3_exec(sqdb, sqlcmd, NULL, NULL, NULL);
+            settle_changes(err);
+            return err;
+        }
+        
+        void
+        insert_all_columns_command(std::string &sqlcmd) {
+            sqlcmd.append("INSERT INTO ");
+            sqlcmd.append(table);
+            sqlcmd.append("(");
+            for (size_t index = 0; index < columns.size(); index++) {
+                if (index != 0) {
+                    sqlcmd.append(",");
+                }
+                sqlcmd.append(columns.at(index));
+            }
+            sqlcmd.append(") VALUES(");
+            for (size_t index = 0; index < columns.size(); index++) {
+                sqlcmd.append(index == 0 ? "?" : ",?");
+            }
+            sqlcmd.append(")");
+        }
+        
+        /**
+         *next_row returns a pointer to the next full row or nullptr when exhausted;
+         *reject(step_err) returning true skips a row whose INSERT failed instead of stopping,
+         *only the failed statement is undone so the batch carries on
+         */
+        template<typename NEXT, typename REJECT>
+        SQLITE_API int SQLITE_STDCALL
+        put_rows_in_batches(NEXT &&next_row, REJECT &&reject, size_t *committed_rows, const batch_options &options) {
+            sqlite_tool::operation_probe probe(instrumentation, sqlite_tool::operation_type::put_rows);
+            size_t committed = 0;
+            if (committed_rows != nullptr) {
+                *committed_rows = 0;
+            }
+            
+            std::string sqlcmd;
+            insert_all_columns_command(sqlcmd);
+            
+            sqlite3_stmt *stmt = nullptr;
+            bool prepared = false;
+            probe.start();
+            SQLITE_API int SQLITE_STDCALL err = prepare_statement(sqlcmd, &stmt, &prepared);
+            probe.prepared(prepared);
+            if (err != SQLITE_OK) {
+                return err;
+            }
+            
+            /**
+             *a savepoint behaves like BEGIN outside a transaction and still nests inside one
+             */
+            err = execute_sql("SAVEPOINT put_rows");
+            if (err != SQLITE_OK) {
+                statements.release(stmt);
+                return err;
+            }
+            size_t savepoint_changes = pending_changes.size();
+            bool in_savepoint = true;
+            size_t pending_rows = 0;
+            size_t pending_bytes = 0;
+            const full_tuple_type *row = nullptr;
+            while ((row = next_row()) != nullptr) {
+                probe.start();
+                err = tuple_utility::bind_row(stmt, *row);
+                probe.bound();
+                if (err != SQLITE_OK) {
+                    break;
+                }
+                probe.start();
+                size_t statement_changes = pending_changes.size();
+                SQLITE_API int SQLITE_STDCALL step_err = sqlite3_step(stmt);
+                probe.stepped(step_err);
+                sqlite3_reset(stmt);
+                if (step_err != SQLITE_DONE) {
+                    discard_changes_since(statement_changes);
+                    if (reject(step_err)) {
+                        continue;
+                    }
+                    err = step_err;
+                    break;
+                }
+                pending_rows++;
+                pending_bytes += tuple_utility::row_bytes(*row);
+                if ((options.max_rows != 0 && pending_rows >= options.max_rows) ||
+                    (options.max_bytes != 0 && pending_bytes >= options.max_bytes)) {
+                    err = execute_sql("RELEASE put_rows");
+                    if (err != SQLITE_OK) {
+                        break;
+                    }
+                    in_savepoint = false;
+                    committed += pending_rows;
+                    pending_rows = 0;
+                    pending_bytes = 0;
+                    err = execute_sql("SAVEPOINT put_rows");
+                    if (err != SQLITE_OK) {
+                        break;
+                    }
+                    savepoint_changes = pending_changes.size();
+                    in_savepoint = true;
+                }
+            }
+            probe.statement(stmt);
+            statements.release(stmt);
+            
+            if (err == SQLITE_OK) {
+                err = execute_sql("RELEASE put_rows");
+                if (err == SQLITE_OK) {
+                    committed += pending_rows;
+                }
+            }
+            if (err != SQLITE_OK && in_savepoint) {
+                execute_sql("ROLLBACK TO put_rows");
+                discard_changes_since(savepoint_changes);
+                execute_sql("RELEASE put_rows");
+            }
+            if (committed_rows != nullptr) {
+                *committed_rows = committed;
+            }
+            return err;
+        }
+        
+    public:
+        /**
+         *insert every row of a range of full_tuple_type through one prepared INSERT,
+         *committing in chunks; on failure committed_rows holds the rows released before the error
+         *(durable once the enclosing transaction, if any, commits)
+         */
+        template<typename RANGE>
+        SQLITE_API int SQLITE_STDCALL
+        put_rows(const RANGE &rows, size_t *committed_rows = nullptr, const batch_options &options = batch_options()) {
+            static_assert(std::is_same<typename std::decay<decltype(*std::begin(rows))>::type, full_tuple_type>::value,
+                          "put_rows expects a range of std::tuple<COLUMN_TYPE...>");
+            auto current = std::begin(rows);
+            auto last = std::end(rows);
+            return put_rows_in_batches([&]() -> const full_tuple_type * {
+                if (current == last) {
+                    return nullptr;
+                }
+                const full_tuple_type &row = *current;
+                ++current;
+                return &row;
+            }, [](int) {
+                return false;
+            }, committed_rows, options);
+        }
+        
+        /**
+         *generator fills the row and returns true, or returns false when there are no more rows
+         */
+        template<typename GENERATOR>
+        SQLITE_API int SQLITE_STDCALL
+        put_rows_from_generator(GENERATOR &&generator, size_t *committed_rows = nullptr, const batch_options &options = batch_options()) {
+            full_tuple_type row;
+            return put_rows_in_batches([&]() -> const full_tuple_type * {
+                return generator(row) ? &row : nullptr;
+            }, [](int) {
+                return false;
+            }, committed_rows, options);
+        }
+        
+    private:
+        /**
+         *rows handed from the parser thread to the inserting thread, positions[i] locates rows[i] in the file
+         */
+        struct import_batch {
+            std::vector<full_tuple_type> rows;
+            std::vector<size_t> positions;
+        };
+        
+        static void
+        keep_reject(std::vector<sqlite_tool::rejected_row> &rejects, size_t limit, size_t position, std::string reason) {
+            if (rejects.size() < limit) {
+                sqlite_tool::rejected_row row;
+                row.position = position;
+                row.reason = std::move(reason);
+                rejects.emplace_back(std::move(row));
+            }
+        }
+        
+        /**
+         *runs on its own thread: read and convert records, queue them in batches;
+         *stops early when the queue is closed by the inserting side
+         */
+        void
+        parse_import_file(sqlite_tool::block_reader &in, const sqlite_tool::import_options &options, sqlite_tool::bounded_queue<import_batch> &queue,
+                          size_t &records, size_t &rejected, std::vector<sqlite_tool::rejected_row> &rejects) {
+            size_t rows_per_batch = options.rows_per_batch == 0 ? 1 : options.rows_per_batch;
+            import_batch batch;
+            batch.rows.reserve(rows_per_batch);
+            std::vector<std::string> fields;
+            std::vector<sqlite_tool::any_mem_t> payload;
+            std::string reason;
+            size_t line = 1;
+            bool skip_header = options.header;
+            for (;;) {
+                full_tuple_type row;
+                size_t position = 0;
+                bool converted = false;
+                if (options.format == sqlite_tool::import_format::csv) {
+                    size_t field_count = 0;
+                    bool malformed = false;
+                    if (!sqlite_tool::import_utility::next_csv_record(in, options.delimiter, fields, field_count, line, position, malformed)) {
+                        break;
+                    }
+                    if (skip_header) {
+                        skip_header = false;
+                        continue;
+                    }
+                    if (malformed) {
+                        reason = "quoted field not closed before the end of the file";
+                    }
+                    else {
+                        converted = sqlite_tool::import_utility::fields_to_row(fields, field_count, row, reason);
+                    }
+                }
+                else {
+                    bool truncated = false;
+                    bool oversized = false;
+                    position = records + 1;
+                    if (!sqlite_tool::import_utility::next_binary_record(in, payload, options.max_record_bytes, truncated, oversized)) {
+                        if (truncated) {
+                            records++;
+                            rejected++;
+                            keep_reject(rejects, options.max_rejects_kept, position, "file ends inside the record");
+                        }
+                        break;
+                    }
+                    if (oversized) {
+                        reason = "record longer than max_record_bytes";
+                    }
+                    else {
+                        converted = sqlite_tool::import_utility::record_to_row(payload.data(), payload.size(), row, reason);
+                    }
+                }
+                records++;
+                if (!converted) {
+                    rejected++;
+                    keep_reject(rejects, options.max_rejects_kept, position, reason);
+                    continue;
+                }
+                batch.rows.emplace_back(std::move(row));
+                batch.positions.push_back(position);
+                if (batch.rows.size() == rows_per_batch) {
+                    if (!queue.push(std::move(batch))) {
+                        return;
+                    }
+                    batch = import_batch();
+                    batch.rows.reserve(rows_per_batch);
+                }
+            }
+            if (!batch.rows.empty()) {
+                queue.push(std::move(batch));
+            }
+            queue.close();
+        }
+        
+    public:
+        /**
+         *stream a csv or binary dump (see import_options) into the table: one thread reads and converts
+         *records to COLUMN_TYPE... while the calling thread binds them into one cached INSERT, committing
+         *per options.commit; records that do not convert, and rows the INSERT rejects with a constraint
+         *or type error, are counted in report and skipped. Returns SQLITE_CANTOPEN or SQLITE_IOERR for
+         *the file, SQLITE_NOMEM when the parser ran out of memory, otherwise the first error that stopped
+         *the import (rows committed before it stay)
+         */
+        SQLITE_API int SQLITE_STDCALL
+        import_file(const std::string &path, sqlite_tool::import_report &report, const sqlite_tool::import_options &options = sqlite_tool::import_options()) {
+            report = sqlite_tool::import_report();
+            std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+            sqlite_tool::block_reader in(path, options.block_bytes);
+            if (!in.is_open()) {
+                return SQLITE_CANTOPEN;
+            }
+            
+            sqlite_tool::bounded_queue<import_batch> queue(options.queued_batches);
+            size_t parsed_rejects = 0;
+            std::vector<sqlite_tool::rejected_row> parse_rejects;
+            SQLITE_API int SQLITE_STDCALL parse_err = SQLITE_OK;
+            std::thread parser([&]() {
+                /**
+                 *an exception must not leave the thread, the inserting side sees the queue end instead
+                 */
+                try {
+                    parse_import_file(in, options, queue, report.records, parsed_rejects, parse_rejects);
+                }
+                catch (const std::bad_alloc &) {
+                    parse_err = SQLITE_NOMEM;
+                }
+                catch (...) {
+                    parse_err = SQLITE_ERROR;
+                }
+                queue.close();
+            });
+            
+            import_batch batch;
+            size_t next = 0;
+            size_t insert_rejects = 0;
+            std::vector<sqlite_tool::rejected_row> step_rejects;
+            SQLITE_API int SQLITE_STDCALL err = put_rows_in_batches([&]() -> const full_tuple_type * {
+                while (next == batch.rows.size()) {
+                    batch.rows.clear();
+                    batch.positions.clear();
+                    next = 0;
+                    if (!queue.pop(batch)) {
+                        return nullptr;
+                    }
+                }
+                return &batch.rows[next++];
+            }, [&](int step_err) {
+                int primary = step_err & 0xff;
+                if (primary != SQLITE_CONSTRAINT && primary != SQLITE_MISMATCH) {
+                    return false;
+                }
+                insert_rejects++;
+                keep_reject(step_rejects, options.max_rejects_kept, batch.positions[next - 1], sqlite3_errmsg(sqdb));
+                return true;
+            }, &report.imported, options.commit);
+            queue.close();
+            parser.join();
+            
+            report.rejected = parsed_rejects + insert_rejects;
+            report.rejects = std::move(parse_rejects);
+            report.rejects.insert(report.rejects.end(), step_rejects.begin(), step_rejects.end());
+            std::sort(report.rejects.begin(), report.rejects.end(), [](const sqlite_tool::rejected_row &left, const sqlite_tool::rejected_row &right) {
+                return left.position < right.position;
+            });
+            if (report.rejects.size() > options.max_rejects_kept) {
+                report.rejects.resize(options.max_rejects_kept);
+            }
+            report.bytes = in.bytes_read();
+            report.elapsed_ns = uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - started).count());
+            if (err == SQLITE_OK && parse_err != SQLITE_OK) {
+                return parse_err;
+            }
+            if (err == SQLITE_OK && in.error()) {
+                return SQLITE_IOERR;
+            }
+            return err;
+        }
+        
+    public:
+        /**
+         *get columns value uses dynamic run-time typing not static
+         */
+        SQLITE_API int SQLITE_STDCALL
+        get_all(std::deque<sqlite3_row> &result) {
+            sqlite_tool::operation_probe probe(instrumentation, sqlite_tool::operation_type::get_all);
+            std::string sqlcmd("SELECT * FROM ");
+            sqlcmd.append(table);
+            
+            connection_lease lease = lease_reader();
+            sqlite3_stmt *stmt = nullptr;
+            bool prepared = false;
+            probe.start();
+            SQLITE_API int SQLITE_STDCALL prep_err = lease.prepare(sqlcmd, &stmt, &prepared);
+            probe.prepared(prepared);
+            if (prep_err != SQLITE_OK) {
+                return prep_err;
+            }
+            
+            sqlite_tool::row_decode_plan plan;
+            SQLITE_API int SQLITE_STDCALL plan_err = plan.build(stmt, db_row);
+            if (plan_err != SQLITE_OK) {
+                lease.release(stmt);
+                return plan_err;
+            }
+            
+            SQLITE_API int SQLITE_STDCALL step_err = SQLITE_OK;
+            probe.start();
+            while ((step_err = sqlite3_step(stmt)) == SQLITE_ROW) {
+                probe.stepped(step_err);
+                sqlite3_row current_row(db_row, db_row_size);
+                plan.decode(stmt, current_row);
+                result.emplace_back(std::move(current_row));
+                probe.start();
+            }//while
+            probe.stepped(step_err);
+            probe.statement(stmt);
+            lease.release(stmt);
+            if (step_err == SQLITE_DONE) {
+                return SQLITE_OK;
+            }
+            else {
+                return step_err;
+            }
+        }
+        
+        /**
+         *all rows into one result set, storage grows per chunk rather than per row or string;
+         *result is reset to this table's columns first
+         */
+        SQLITE_API int SQLITE_STDCALL
+        get_all(sqlite3_result_set &result) {
+            sqlite_tool::operation_probe probe(instrumentation, sqlite_tool::operation_type::get_all);
+            std::string sqlcmd("SELECT * FROM ");
+            sqlcmd.append(table);
+            result.reset(db_row);
+            
+            connection_lease lease = lease_reader();
+            sqlite3_stmt *stmt = nullptr;
+            bool prepared = false;
+            probe.start();
+            SQLITE_API int SQLITE_STDCALL prep_err = lease.prepare(sqlcmd, &stmt, &prepared);
+            probe.prepared(prepared);
+            if (prep_err != SQLITE_OK) {
+                return prep_err;
+            }
+            
+            SQLITE_API int SQLITE_STDCALL step_err = SQLITE_OK;
+            probe.start();
+            while ((step_err = sqlite3_step(stmt)) == SQLITE_ROW) {
+                probe.stepped(step_err);
+                result.append(stmt);
+                probe.start();
+            }
+            probe.stepped(step_err);
+            probe.statement(stmt);
+            lease.release(stmt);
+            if (step_err == SQLITE_DONE) {
+                return SQLITE_OK;
+            }
+            else {
+                return step_err;
+            }
+        }
+        
+    private:
+        /**
+         *SELECT list holds only the requested columns, in the requested order,
+         *so result column i is tuple element i
+         */
+        template<size_t...col_x>
+        void
+        select_columns_command(std::string &sqlcmd) {
+            const std::array<size_t, sizeof...(col_x)> selected = {{col_x...}};
+            sqlcmd.append("SELECT ");
+            for (size_t index = 0; index < selected.size(); index++) {
+                if (index != 0) {
+                    sqlcmd.append(",");
+                }
+                sqlcmd.append(columns.at(selected[index]));
+            }
+            sqlcmd.append(" FROM ");
+            sqlcmd.append(table);
+        }
+        
+    public:
+        /**
+         *get columns value uses static not dynamic run-time typing
+         */
+        template<size_t...col_x>
+        std::deque<std::tuple<typename std::tuple_element<col_x, full_tuple_type>::type...>>
+        get_column_value() {
+            std::string sqlcmd;
+            select_columns_command<col_x...>(sqlcmd);
+            return cached_rows<col_x...>(sqlcmd, std::vector<sqlite_tool::bound_value>(), sqlite_tool::operation_type::get_column_value);
+        }
+        
+    private:
+        /**
+         *condition parameters are the last ? placeholders of every statement that has a WHERE clause
+         */
+        SQLITE_API int SQLITE_STDCALL
+        bind_condition_values(sqlite3_stmt *stmt, const std::vector<sqlite_tool::bound_value> &values) {
+            int first_parameter = sqlite3_bind_parameter_count(stmt) - int(values.size()) + 1;
+            for (size_t index = 0; index < values.size(); index++) {
+                SQLITE_API int SQLITE_STDCALL bind_err = values.at(index).bind(stmt, first_parameter + int(index));
+                if (bind_err != SQLITE_OK) {
+                    return bind_err;
+                }
+            }
+            return SQLITE_OK;
+        }
+        
+        /**
+         *every row of sqlcmd appended to result
+         */
+        template<size_t...col_x>
+        SQLITE_API int SQLITE_STDCALL
+        select_rows(const std::string &sqlcmd, const std::vector<sqlite_tool::bound_value> &values, sqlite_tool::operation_type type, std::deque<std::tuple<typename std::tuple_element<col_x, full_tuple_type>::type...>> &result) {
+            sqlite_tool::operation_probe probe(instrumentation, type);
+            connection_lease lease = lease_reader();
+            sqlite3_stmt *stmt = nullptr;
+            bool prepared = false;
+            probe.start();
+            SQLITE_API int SQLITE_STDCALL prep_err = lease.prepare(sqlcmd, &stmt, &prepared);
+            probe.prepared(prepared);
+            if (prep_err != SQLITE_OK) {
+                return prep_err;
+            }
+            
+            probe.start();
+            SQLITE_API int SQLITE_STDCALL bind_err = bind_condition_values(stmt, values);
+            probe.bound();
+            if (bind_err != SQLITE_OK) {
+                lease.release(stmt);
+                return bind_err;
+            }
+            
+            SQLITE_API int SQLITE_STDCALL step_err = SQLITE_OK;
+            probe.start();
+            while ((step_err = sqlite3_step(stmt)) == SQLITE_ROW) {
+                probe.stepped(step_err);
+                result.emplace_back();
+                tuple_utility::get_row(stmt, result.back());
+                probe.start();
+            }
+            probe.stepped(step_err);
+            probe.statement(stmt);
+            lease.release(stmt);
+            if (step_err == SQLITE_DONE) {
+                return SQLITE_OK;
+            }
+            else {
+                return step_err;
+            }
+        }
+        
+        /**
+         *select_rows through the result cache when it is enabled; a failed query returns the rows
+         *read before the error and is never cached
+         */
+        template<size_t...col_x>
+        std::deque<std::tuple<typename std::tuple_element<col_x, full_tuple_type>::type...>>
+        cached_rows(const std::string &sqlcmd, const std::vector<sqlite_tool::bound_value> &values, sqlite_tool::operation_type type) {
+            typedef std::deque<std::tuple<typename std::tuple_element<col_x, full_tuple_type>::type...>> rows_type;
+            if (!cache) {
+                rows_type rows;
+                select_rows<col_x...>(sqlcmd, values, type, rows);
+                return rows;
+            }
+            cache->check_data_version();
+            std::string key = sqlite_tool::result_cache::make_key(sqlcmd, values);
+            std::shared_ptr<const void> found = cache->find(key);
+            if (found) {
+                return *std::static_pointer_cast<const rows_type>(found);
+            }
+            uint64_t generation = cache->generation();
+            std::shared_ptr<rows_type> rows = std::make_shared<rows_type>();
+            if (select_rows<col_x...>(sqlcmd, values, type, *rows) != SQLITE_OK) {
+                return std::move(*rows);
+            }
+            size_t bytes = rows->size() * sizeof(typename rows_type::value_type);
+            for (const typename rows_type::value_type &row : *rows) {
+                bytes += tuple_utility::row_bytes(row);
+            }
+            cache->insert(std::move(key), rows, bytes, generation);
+            return *rows;
+        }
+        
+        template<size_t...col_x>
+        std::deque<std::tuple<typename std::tuple_element<col_x, full_tuple_type>::type...>>
+        get_column_value_where(const std::string &conditions, const std::vector<sqlite_tool::bound_value> &values) {
+            std::string sqlcmd;
+            select_columns_command<col_x...>(sqlcmd);
+            sqlcmd.append(" WHERE ");
+            sqlcmd.append(conditions);
+            return cached_rows<col_x...>(sqlcmd, values, sqlite_tool::operation_type::get_column_value_match_conditions);
+        }
+        
+    public:
+        template<size_t...col_x>
+        std::deque<std::tuple<typename std::tuple_element<col_x, full_tuple_type>::type...>>
+        get_column_value_match_conditions() {
+            return get_column_value_where<col_x...>(execute_conditions, condition_values);
+        }
+        
+        /**
+         *uses the given condition instead of the one set on the delegate
+         */
+        template<size_t...col_x>
+        std::deque<std::tuple<typename std::tuple_element<col_x, full_tuple_type>::type...>>
+        get_column_value_match_conditions(const sqlite_tool::sqlite3_condition &condition) {
+            return get_column_value_where<col_x...>(condition.render(columns), condition.parameters());
+        }
+
     public:
-        template<typename COLTP, typename...VALTP>
-        SQLITE_API int SQLITE_STDCALL
-        put_row(std::pair<COLTP, VALTP>...pair) {
-            size_t parameters = sizeof...(VALTP);
-            if (parameters > std::tuple_size<full_tuple_type>::value) {
-                return SQLITE_ERROR;
+        template<size_t sort_col, size_t...col_x>
+        using page_type = sqlite_tool::value_page<typename std::tuple_element<sort_col, full_tuple_type>::type, typename std::tuple_element<col_x, full_tuple_type>::type...>;
+        
+    private:
+        /**
+         *SELECT sort, rowid, col_x... WHERE (sort, rowid) > (?, ?) AND conditions ORDER BY sort, rowid LIMIT page_size;
+         *the keyset comparison comes first so the condition values stay the trailing parameters,
+         *and page_size is written into the sql, a caller keeps one page size so the statement is reused
+         */
+        template<size_t sort_col, size_t...col_x>
+        page_type<sort_col, col_x...>
+        get_page_where(const std::string &conditions, const std::vector<sqlite_tool::bound_value> &values, size_t page_size, const sqlite_tool::page_token<typename std::tuple_element<sort_col, full_tuple_type>::type> &after) {
+            sqlite_tool::operation_probe probe(instrumentation, sqlite_tool::operation_type::get_column_value_page);
+            page_type<sort_col, col_x...> page;
+            page.next = after;
+            if (after.finished || page_size == 0) {
+                return page;
             }
-            
-            std::string sqlcmd("INSERT INTO ");
+            const std::string &sort = columns.at(sort_col);
+            const std::array<size_t, sizeof...(col_x)> selected = {{col_x...}};
+            std::string sqlcmd("SELECT ");
+            sqlcmd.append(sort);
+            sqlcmd.append(",rowid");
+            for (size_t index = 0; index < selected.size(); index++) {
+                sqlcmd.append(",");
+                sqlcmd.append(columns.at(selected[index]));
+            }
+            sqlcmd.append(" FROM ");
             sqlcmd.append(table);
-            sqlcmd.append("(");
-            insert_command_prepare_name(sqlcmd, pair...);
-            sqlcmd.append(") VALUES(");
-            //insert_command_prepare_value(sqlcmd, std::forward<std::pair<COLTP, VALTP>>(pair)...);
-            insert_command_prepare_value(sqlcmd, bind_column_index_transfer_to_name(pair)...);
-            sqlcmd.append(")");
+            sqlcmd.append(" WHERE ");
+            if (after.started) {
+                sqlcmd.append("(");
+                sqlcmd.append(sort);
+                sqlcmd.append(",rowid) > (?,?)");
+            }
+            else {
+                sqlcmd.append(sort);
+                sqlcmd.append(" IS NOT NULL");
+            }
+            if (!conditions.empty()) {
+                sqlcmd.append(" AND (");
+                sqlcmd.append(conditions);
+                sqlcmd.append(")");
+            }
+            sqlcmd.append(" ORDER BY ");
+            sqlcmd.append(sort);
+            sqlcmd.append(",rowid LIMIT ");
+            sqlcmd.append(std::to_string(page_size));
             
-            if (sqdb == nullptr) {
-                SQLITE_API int SQLITE_STDCALL open_err = open_db();
-                if (open_err != SQLITE_OK) {
-                    return open_err;
+            connection_lease lease = lease_reader();
+            sqlite3_stmt *stmt = nullptr;
+            bool prepared = false;
+            probe.start();
+            page.error = lease.prepare(sqlcmd, &stmt, &prepared);
+            probe.prepared(prepared);
+            if (page.error != SQLITE_OK) {
+                return page;
+            }
+            probe.start();
+            if (after.started) {
+                page.error = bind_utility::bind_parameter(stmt, 1, after.key);
+                if (page.error == SQLITE_OK) {
+                    page.error = bind_utility::bind_parameter(stmt, 2, after.rowid);
                 }
             }
+            if (page.error == SQLITE_OK) {
+                page.error = bind_condition_values(stmt, values);
+            }
+            probe.bound();
+            if (page.error != SQLITE_OK) {
+                lease.release(stmt);
+                return page;
+            }
             
+            SQLITE_API int SQLITE_STDCALL step_err = SQLITE_OK;
+            probe.start();
+            while ((step_err = sqlite3_step(stmt)) == SQLITE_ROW) {
+                probe.stepped(step_err);
+                stmt_utility::stmt_get_column(stmt, 0, page.next.key);
+                stmt_utility::stmt_get_column(stmt, 1, page.next.rowid);
+                page.rows.emplace_back();
+                tuple_utility::get_row(stmt, page.rows.back(), 2);
+                probe.start();
+            }
+            probe.stepped(step_err);
+            probe.statement(stmt);
+            lease.release(stmt);
+            if (step_err != SQLITE_DONE) {
+                page.error = step_err;
+                page.rows.clear();
+                page.next = after;
+                return page;
+            }
+            page.next.started = true;
+            page.next.finished = page.rows.size() < page_size;
+            return page;
+        }
+        
+    public:
+        /**
+         *keyset pagination ordered by column sort_col (ties broken by rowid), each page costs O(page_size):
+         *auto page = sq_delegate.get_column_value_page<0, 1, 2>(100);
+         *while (!page.rows.empty()) { ...; page = sq_delegate.get_column_value_page<0, 1, 2>(100, page.next); }
+         *rows whose sort value is NULL are never returned
+         */
+        template<size_t sort_col, size_t...col_x>
+        page_type<sort_col, col_x...>
+        get_column_value_page(size_t page_size, const sqlite_tool::page_token<typename std::tuple_element<sort_col, full_tuple_type>::type> &after = sqlite_tool::page_token<typename std::tuple_element<sort_col, full_tuple_type>::type>()) {
+            return get_page_where<sort_col, col_x...>(std::string(), std::vector<sqlite_tool::bound_value>(), page_size, after);
+        }
+        
+        template<size_t sort_col, size_t...col_x>
+        page_type<sort_col, col_x...>
+        get_column_value_match_conditions_page(size_t page_size, const sqlite_tool::page_token<typename std::tuple_element<sort_col, full_tuple_type>::type> &after = sqlite_tool::page_token<typename std::tuple_element<sort_col, full_tuple_type>::type>()) {
+            return get_page_where<sort_col, col_x...>(execute_conditions, condition_values, page_size, after);
+        }
+        
+        template<size_t sort_col, size_t...col_x>
+        page_type<sort_col, col_x...>
+        get_column_value_match_conditions_page(const sqlite_tool::sqlite3_condition &condition, size_t page_size, const sqlite_tool::page_token<typename std::tuple_element<sort_col, full_tuple_type>::type> &after = sqlite_tool::page_token<typename std::tuple_element<sort_col, full_tuple_type>::type>()) {
+            return get_page_where<sort_col, col_x...>(condition.render(columns), condition.parameters(), page_size, after);
+        }
+        
+    public:
+        template<size_t...col_x>
+        using columnar_type = sqlite_tool::columnar_result<typename std::tuple_element<col_x, full_tuple_type>::type...>;
+        
+    private:
+        /**
+         *rowid ranges up to this many rows are trusted as the row count, wider ones are counted
+         */
+        static const size_t estimate_range_limit = 65536;
+        
+        SQLITE_API int SQLITE_STDCALL
+        single_count(connection_lease &lease, const std::string &sqlcmd, size_t &count) {
+            count = 0;
             sqlite3_stmt *stmt = nullptr;
-            SQLITE_API int SQLITE_STDCALL prep_err = sqlite3_prepare_v2(sqdb, sqlcmd.c_str(), int(sqlcmd.size()), &stmt, NULL);
+            SQLITE_API int SQLITE_STDCALL prep_err = lease.prepare(sqlcmd, &stmt);
             if (prep_err != SQLITE_OK) {
                 return prep_err;
             }
+            SQLITE_API int SQLITE_STDCALL step_err = sqlite3_step(stmt);
+            if (step_err == SQLITE_ROW) {
+                sqlite3_int64 rows = sqlite3_column_int64(stmt, 0);
+                count = rows > 0 ? size_t(rows) : 0;
+                step_err = SQLITE_OK;
+            }
+            lease.release(stmt);
+            return step_err;
+        }
+        
+        /**
+         *rows to reserve for the whole table: the rowid range when it is narrow (an upper bound,
+         *at most estimate_range_limit rows too many), else count(*), so sparse rowids such as
+         *INTEGER PRIMARY KEY ids never reserve far more than the table holds. min and max stay in
+         *separate subqueries, SQLite only reads them from the ends of the rowid b-tree when each is
+         *alone in its SELECT
+         */
+        size_t
+        estimate_row_count(connection_lease &lease) {
+            std::string sqlcmd("SELECT (SELECT max(rowid) FROM ");
+            sqlcmd.append(table);
+            sqlcmd.append(") - (SELECT min(rowid) FROM ");
+            sqlcmd.append(table);
+            sqlcmd.append(") + 1");
+            size_t estimate = 0;
+            if (single_count(lease, sqlcmd, estimate) != SQLITE_OK) {
+                return 0;
+            }
+            if (estimate <= estimate_range_limit) {
+                return estimate;
+            }
+            sqlcmd.assign("SELECT count(*) FROM ");
+            sqlcmd.append(table);
+            if (single_count(lease, sqlcmd, estimate) != SQLITE_OK) {
+                return 0;
+            }
+            return estimate;
+        }
+        
+        template<size_t...col_x>
+        SQLITE_API int SQLITE_STDCALL
+        get_columnar_where(const std::string &sqlcmd, const std::vector<sqlite_tool::bound_value> &values, columnar_type<col_x...> &result, size_t expected_rows, bool whole_table) {
+            sqlite_tool::operation_probe probe(instrumentation, sqlite_tool::operation_type::get_columnar);
+            result.clear();
+            connection_lease lease = lease_reader();
+            if (lease.error() != SQLITE_OK) {
+                return lease.error();
+            }
+            result.reserve(whole_table ? estimate_row_count(lease) : expected_rows);
             
-            SQLITE_API int SQLITE_STDCALL bind_err = bind_utility::bind_value(stmt, bind_column_index_transfer_to_name(pair)...);
+            sqlite3_stmt *stmt = nullptr;
+            bool prepared = false;
+            probe.start();
+            SQLITE_API int SQLITE_STDCALL prep_err = lease.prepare(sqlcmd, &stmt, &prepared);
+            probe.prepared(prepared);
+            if (prep_err != SQLITE_OK) {
+                return prep_err;
+            }
+            probe.start();
+            SQLITE_API int SQLITE_STDCALL bind_err = bind_condition_values(stmt, values);
+            probe.bound();
             if (bind_err != SQLITE_OK) {
-                sqlite3_clear_bindings(stmt);
-                sqlite3_finalize(stmt);
+                lease.release(stmt);
                 return bind_err;
             }
             
-            SQLITE_API int SQLITE_STDCALL step_err = sqlite3_step(stmt);
-            sqlite3_clear_bindings(stmt);
-            sqlite3_finalize(stmt);
-            if (step_err != SQLITE_DONE) {
+            SQLITE_API int SQLITE_STDCALL step_err = SQLITE_OK;
+            probe.start();
+            while ((step_err = sqlite3_step(stmt)) == SQLITE_ROW) {
+                probe.stepped(step_err);
+                result.append(stmt);
+                probe.start();
+            }
+            probe.stepped(step_err);
+            probe.statement(stmt);
+            lease.release(stmt);
+            if (step_err == SQLITE_DONE) {
+                return SQLITE_OK;
+            }
+            else {
                 return step_err;
             }
+        }
+        
+    public:
+        /**
+         *columnar counterpart of get_column_value, vectors are reserved from the table's rowid range:
+         *sqlite3_delegate<...>::columnar_type<0, 1> result; sq_delegate.get_columnar<0, 1>(result);
+         */
+        template<size_t...col_x>
+        SQLITE_API int SQLITE_STDCALL
+        get_columnar(columnar_type<col_x...> &result) {
+            std::string sqlcmd;
+            select_columns_command<col_x...>(sqlcmd);
+            return get_columnar_where<col_x...>(sqlcmd, std::vector<sqlite_tool::bound_value>(), result, 0, true);
+        }
+        
+        /**
+         *expected_rows sizes the vectors up front, the table's row count is not a useful guess for a filtered result
+         */
+        template<size_t...col_x>
+        SQLITE_API int SQLITE_STDCALL
+        get_columnar_match_conditions(columnar_type<col_x...> &result, size_t expected_rows = 0) {
+            std::string sqlcmd;
+            select_columns_command<col_x...>(sqlcmd);
+            sqlcmd.append(" WHERE ");
+            sqlcmd.append(execute_conditions);
+            return get_columnar_where<col_x...>(sqlcmd, condition_values, result, expected_rows, false);
+        }
+        
+        template<size_t...col_x>
+        SQLITE_API int SQLITE_STDCALL
+        get_columnar_match_conditions(const sqlite_tool::sqlite3_condition &condition, columnar_type<col_x...> &result, size_t expected_rows = 0) {
+            std::string sqlcmd;
+            select_columns_command<col_x...>(sqlcmd);
+            sqlcmd.append(" WHERE ");
+            sqlcmd.append(condition.render(columns));
+            return get_columnar_where<col_x...>(sqlcmd, condition.parameters(), result, expected_rows, false);
+        }
+        
+    private:
+        template<size_t...col_x>
+        sqlite3_cursor<typename std::tuple_element<col_x, full_tuple_type>::type...>
+        open_cursor(const std::string &sqlcmd, const std::vector<sqlite_tool::bound_value> &values) {
+            sqlite_tool::operation_probe probe(instrumentation, sqlite_tool::operation_type::scan);
+            connection_lease lease = lease_reader();
+            sqlite3_stmt *stmt = nullptr;
+            bool prepared = false;
+            probe.start();
+            SQLITE_API int SQLITE_STDCALL prep_err = lease.prepare(sqlcmd, &stmt, &prepared);
+            probe.prepared(prepared);
+            if (prep_err != SQLITE_OK) {
+                stmt = nullptr;
+            }
+            else {
+                probe.start();
+                prep_err = bind_condition_values(stmt, values);
+                probe.bound();
+                if (prep_err != SQLITE_OK) {
+                    lease.release(stmt);
+                    stmt = nullptr;
+                }
+            }
+            return sqlite3_cursor<typename std::tuple_element<col_x, full_tuple_type>::type...>(std::move(lease), stmt, prep_err);
+        }
+        
+    public:
+        /**
+         *lazy counterpart of get_column_value, rows are decoded one sqlite3_step at a time:
+         *for (auto &&row : sq_delegate.scan<0, 2>()) { ... }
+         */
+        template<size_t...col_x>
+        sqlite3_cursor<typename std::tuple_element<col_x, full_tuple_type>::type...>
+        scan() {
+            std::string sqlcmd;
+            select_columns_command<col_x...>(sqlcmd);
+            return open_cursor<col_x...>(sqlcmd, std::vector<sqlite_tool::bound_value>());
+        }
+        
+        template<size_t...col_x>
+        sqlite3_cursor<typename std::tuple_element<col_x, full_tuple_type>::type...>
+        scan_match_conditions() {
+            std::string sqlcmd;
+            select_columns_command<col_x...>(sqlcmd);
+            sqlcmd.append(" WHERE ");
+            sqlcmd.append(execute_conditions);
+            return open_cursor<col_x...>(sqlcmd, condition_values);
+        }
+        
+        template<size_t...col_x>
+        sqlite3_cursor<typename std::tuple_element<col_x, full_tuple_type>::type...>
+        scan_match_conditions(const sqlite_tool::sqlite3_condition &condition) {
+            std::string sqlcmd;
+            select_columns_command<col_x...>(sqlcmd);
+            sqlcmd.append(" WHERE ");
+            sqlcmd.append(condition.render(columns));
+            return open_cursor<col_x...>(sqlcmd, condition.parameters());
+        }
+
+    private:
+        template<size_t...col_x, typename VISITOR>
+        SQLITE_API int SQLITE_STDCALL
+        visit_rows(const std::string &sqlcmd, const std::vector<sqlite_tool::bound_value> &values, VISITOR &&visitor) {
+            sqlite_tool::operation_probe probe(instrumentation, sqlite_tool::operation_type::visit);
+            connection_lease lease = lease_reader();
+            sqlite3_stmt *stmt = nullptr;
+            bool prepared = false;
+            probe.start();
+            SQLITE_API int SQLITE_STDCALL prep_err = lease.prepare(sqlcmd, &stmt, &prepared);
+            probe.prepared(prepared);
+            if (prep_err != SQLITE_OK) {
+                return prep_err;
+            }
+            probe.start();
+            SQLITE_API int SQLITE_STDCALL bind_err = bind_condition_values(stmt, values);
+            probe.bound();
+            if (bind_err != SQLITE_OK) {
+                lease.release(stmt);
+                return bind_err;
+            }
             
-            return SQLITE_OK;
+            std::tuple<typename column_view<typename std::tuple_element<col_x, full_tuple_type>::type>::type...> row;
+            SQLITE_API int SQLITE_STDCALL step_err = SQLITE_OK;
+            probe.start();
+            while ((step_err = sqlite3_step(stmt)) == SQLITE_ROW) {
+                probe.stepped(step_err);
+                tuple_utility::get_row(stmt, row);
+                tuple_utility::apply(visitor, row);
+                probe.start();
+            }
+            probe.stepped(step_err);
+            probe.statement(stmt);
+            lease.release(stmt);
+            if (step_err == SQLITE_DONE) {
+                return SQLITE_OK;
+            }
+            else {
+                return step_err;
+            }
         }
         
     public:
         /**
-         *get columns value uses dynamic run-time typing not static
+         *calls visitor once per row without copying TEXT/BLOB values, they arrive as text_view/blob_view
+         *pointing into SQLite's row buffer and must not be kept after the call returns:
+         *sq_delegate.visit<0, 2>([&](sqlite_tool::integer id, sqlite_tool::text_view name) { ... });
          */
+        template<size_t...col_x, typename VISITOR>
         SQLITE_API int SQLITE_STDCALL
-        get_all(std::deque<sqlite3_row> &result) {
-            std::string sqlcmd("SELECT * FROM ");
+        visit(VISITOR &&visitor) {
+            std::string sqlcmd;
+            select_columns_command<col_x...>(sqlcmd);
+            return visit_rows<col_x...>(sqlcmd, std::vector<sqlite_tool::bound_value>(), std::forward<VISITOR>(visitor));
+        }
+        
+        template<size_t...col_x, typename VISITOR>
+        SQLITE_API int SQLITE_STDCALL
+        visit_match_conditions(VISITOR &&visitor) {
+            std::string sqlcmd;
+            select_columns_command<col_x...>(sqlcmd);
+            sqlcmd.append(" WHERE ");
+            sqlcmd.append(execute_conditions);
+            return visit_rows<col_x...>(sqlcmd, condition_values, std::forward<VISITOR>(visitor));
+        }
+        
+        template<size_t...col_x, typename VISITOR>
+        SQLITE_API int SQLITE_STDCALL
+        visit_match_conditions(const sqlite_tool::sqlite3_condition &condition, VISITOR &&visitor) {
+            std::string sqlcmd;
+            select_columns_command<col_x...>(sqlcmd);
+            sqlcmd.append(" WHERE ");
+            sqlcmd.append(condition.render(columns));
+            return visit_rows<col_x...>(sqlcmd, condition.parameters(), std::forward<VISITOR>(visitor));
+        }
+
+    private:
+        /**
+         *[min(rowid), max(rowid)] cut into at most count contiguous ranges of equal width,
+         *no ranges for an empty table; gaps in the rowids make some ranges lighter than others
+         */
+        SQLITE_API int SQLITE_STDCALL
+        rowid_ranges(size_t count, std::vector<std::pair<sqlite_tool::integer, sqlite_tool::integer>> &ranges) {
+            ranges.clear();
+            std::string sqlcmd("SELECT (SELECT min(rowid) FROM ");
             sqlcmd.append(table);
-            
-            if (sqdb == nullptr) {
-                SQLITE_API int SQLITE_STDCALL open_err = open_db();
+            sqlcmd.append("), (SELECT max(rowid) FROM ");
+            sqlcmd.append(table);
+            sqlcmd.append(")");
+            connection_lease lease = lease_reader();
+            sqlite3_stmt *stmt = nullptr;
+            SQLITE_API int SQLITE_STDCALL prep_err = lease.prepare(sqlcmd, &stmt);
+            if (prep_err != SQLITE_OK) {
+                return prep_err;
+            }
+            SQLITE_API int SQLITE_STDCALL step_err = sqlite3_step(stmt);
+            bool empty_table = step_err != SQLITE_ROW || sqlite3_column_type(stmt, 0) == SQLITE_NULL;
+            sqlite_tool::integer first = sqlite3_column_int64(stmt, 0);
+            sqlite_tool::integer last = sqlite3_column_int64(stmt, 1);
+            lease.release(stmt);
+            if (step_err != SQLITE_ROW) {
+                return step_err == SQLITE_DONE ? SQLITE_OK : step_err;
+            }
+            if (empty_table) {
+                return SQLITE_OK;
+            }
+            uint64_t span = uint64_t(last) - uint64_t(first) + 1;
+            if (span == 0) {
+                span = UINT64_MAX;
+            }
+            if (count > span) {
+                count = size_t(span);
+            }
+            uint64_t width = span / count;
+            uint64_t remainder = span % count;
+            uint64_t begin = uint64_t(first);
+            for (size_t index = 0; index < count; index++) {
+                uint64_t size = width + (index < remainder ? 1 : 0);
+                ranges.emplace_back(sqlite_tool::integer(begin), sqlite_tool::integer(begin + size - 1));
+                begin += size;
+            }
+            return SQLITE_OK;
+        }
+
+        /**
+         *ranges are smaller than a worker's share so a worker that drew sparse ranges takes more of them
+         */
+        static const size_t scan_ranges_per_worker = 4;
+        
+        static size_t
+        scan_workers(size_t workers) {
+            if (workers != 0) {
+                return workers;
+            }
+            size_t cores = std::thread::hardware_concurrency();
+            return cores == 0 ? 1 : cores;
+        }
+
+        /**
+         *workers share the rowid ranges through one counter, range r only ever reaches sink(r, row)
+         *on one thread; each worker holds one read-only connection and one statement for all its ranges.
+         *the first exception thrown on any thread stops the others and is rethrown once all have joined
+         */
+        template<size_t...col_x, typename SINK>
+        SQLITE_API int SQLITE_STDCALL
+        parallel_scan_where(const std::string &conditions, const std::vector<sqlite_tool::bound_value> &values, size_t workers, size_t &range_count, SINK &&sink) {
+            typedef std::tuple<typename std::tuple_element<col_x, full_tuple_type>::type...> row_type;
+            workers = scan_workers(workers);
+
+            /**
+             *a :memory: database is private to the delegate's connection, it is scanned there on one thread
+             */
+            bool private_db = readers.size() == 0 && (db_file.empty() || db_file == ":memory:" || flusher);
+            if (private_db) {
+                workers = 1;
+            }
+            std::vector<std::pair<sqlite_tool::integer, sqlite_tool::integer>> ranges;
+            SQLITE_API int SQLITE_STDCALL range_err = rowid_ranges(workers * scan_ranges_per_worker, ranges);
+            range_count = ranges.size();
+            if (range_err != SQLITE_OK || ranges.empty()) {
+                return range_err;
+            }
+            workers = std::min(workers, ranges.size());
+
+            sqlite_tool::reader_pool scan_readers;
+            sqlite_tool::reader_pool *pool = readers.size() != 0 ? &readers : &scan_readers;
+            if (!private_db && pool == &scan_readers) {
+                SQLITE_API int SQLITE_STDCALL open_err = scan_readers.open(db_file, workers, options);
                 if (open_err != SQLITE_OK) {
                     return open_err;
                 }
             }
-            
+
+            std::string sqlcmd;
+            select_columns_command<col_x...>(sqlcmd);
+            sqlcmd.append(" WHERE rowid BETWEEN ? AND ?");
+            if (!conditions.empty()) {
+                sqlcmd.append(" AND (");
+                sqlcmd.append(conditions);
+                sqlcmd.append(")");
+            }
+
+            std::atomic<size_t> next_range(0);
+            std::atomic<int> scan_err(SQLITE_OK);
+            std::exception_ptr thrown;
+            std::mutex thrown_mutex;
+            auto fail = [&](int err) {
+                int expected = SQLITE_OK;
+                scan_err.compare_exchange_strong(expected, err);
+            };
+            auto work = [&]() {
+                sqlite_tool::operation_probe probe(instrumentation, sqlite_tool::operation_type::parallel_scan);
+                connection_lease lease = private_db ? lease_reader() : connection_lease(pool);
+                sqlite3_stmt *stmt = nullptr;
+                bool prepared = false;
+                probe.start();
+                SQLITE_API int SQLITE_STDCALL err = lease.prepare(sqlcmd, &stmt, &prepared);
+                probe.prepared(prepared);
+                if (err != SQLITE_OK) {
+                    fail(err);
+                    return;
+                }
+                probe.start();
+                err = bind_condition_values(stmt, values);
+                probe.bound();
+                row_type row;
+                size_t range = 0;
+                try {
+                    while (err == SQLITE_OK && scan_err.load() == SQLITE_OK && (range = next_range.fetch_add(1)) < ranges.size()) {
+                        probe.start();
+                        err = bind_utility::bind_parameter(stmt, 1, ranges[range].first);
+                        if (err == SQLITE_OK) {
+                            err = bind_utility::bind_parameter(stmt, 2, ranges[range].second);
+                        }
+                        probe.bound();
+                        if (err != SQLITE_OK) {
+                            break;
+                        }
+                        SQLITE_API int SQLITE_STDCALL step_err = SQLITE_OK;
+                        probe.start();
+                        while ((step_err = sqlite3_step(stmt)) == SQLITE_ROW) {
+                            probe.stepped(step_err);
+                            tuple_utility::get_row(stmt, row);
+                            sink(range, row);
+                            probe.start();
+                        }
+                        probe.stepped(step_err);
+                        sqlite3_reset(stmt);
+                        err = step_err == SQLITE_DONE ? SQLITE_OK : step_err;
+                    }
+                } catch (...) {
+                    sqlite3_reset(stmt);
+                    lease.release(stmt);
+                    throw;
+                }
+                probe.statement(stmt);
+                lease.release(stmt);
+                if (err != SQLITE_OK) {
+                    fail(err);
+                }
+            };
+            auto guarded_work = [&]() {
+                try {
+                    work();
+                } catch (...) {
+                    std::lock_guard<std::mutex> lock(thrown_mutex);
+                    if (!thrown) {
+                        thrown = std::current_exception();
+                    }
+                    fail(SQLITE_ABORT);
+                }
+            };
+
+            std::vector<std::thread> threads;
+            {
+                /**
+                 *joins whatever was started even when starting the next thread throws
+                 */
+                struct thread_joiner {
+                    std::vector<std::thread> &threads;
+                    
+                    ~thread_joiner() {
+                        for (std::thread &thread : threads) {
+                            thread.join();
+                        }
+                    }
+                } joiner{threads};
+                for (size_t index = 1; index < workers; index++) {
+                    threads.emplace_back(guarded_work);
+                }
+                guarded_work();
+            }
+            if (thrown) {
+                std::rethrow_exception(thrown);
+            }
+            return scan_err.load();
+        }
+
+        template<size_t...col_x>
+        SQLITE_API int SQLITE_STDCALL
+        get_column_value_parallel_where(const std::string &conditions, const std::vector<sqlite_tool::bound_value> &values, std::deque<std::tuple<typename std::tuple_element<col_x, full_tuple_type>::type...>> &result, size_t workers) {
+            typedef std::tuple<typename std::tuple_element<col_x, full_tuple_type>::type...> row_type;
+            result.clear();
+            workers = scan_workers(workers);
+            std::vector<std::deque<row_type>> parts(workers * scan_ranges_per_worker);
+            size_t range_count = 0;
+            SQLITE_API int SQLITE_STDCALL err = parallel_scan_where<col_x...>(conditions, values, workers, range_count, [&parts](size_t range, row_type &row) {
+                parts[range].emplace_back(std::move(row));
+            });
+            if (err != SQLITE_OK) {
+                return err;
+            }
+            for (size_t range = 0; range < range_count; range++) {
+                std::move(parts[range].begin(), parts[range].end(), std::back_inserter(result));
+                std::deque<row_type>().swap(parts[range]);
+            }
+            return SQLITE_OK;
+        }
+
+    public:
+        /**
+         *full scan split by rowid range over workers threads (0: one per core), each with its own
+         *read-only connection, so decoding runs on every core; visitor(values...) is called
+         *concurrently from the workers and must be thread-safe, rows arrive in no particular order.
+         *Readers come from open_reader_pool when it is open, otherwise they are opened for the call;
+         *writes not yet committed on the delegate's connection are not seen. Every range is read in a
+         *snapshot of its own, so commits made during the scan may show in some ranges and not others.
+         *A visitor exception stops the scan and is rethrown on the calling thread.
+         *a :memory: database is scanned on the calling thread
+         */
+        template<size_t...col_x, typename VISITOR>
+        SQLITE_API int SQLITE_STDCALL
+        parallel_scan(VISITOR &&visitor, size_t workers = 0) {
+            size_t range_count = 0;
+            return parallel_scan_where<col_x...>(std::string(), std::vector<sqlite_tool::bound_value>(), workers, range_count, [&visitor](size_t, std::tuple<typename std::tuple_element<col_x, full_tuple_type>::type...> &row) {
+                tuple_utility::apply(visitor, row);
+            });
+        }
+
+        template<size_t...col_x, typename VISITOR>
+        SQLITE_API int SQLITE_STDCALL
+        parallel_scan_match_conditions(VISITOR &&visitor, size_t workers = 0) {
+            size_t range_count = 0;
+            return parallel_scan_where<col_x...>(execute_conditions, condition_values, workers, range_count, [&visitor](size_t, std::tuple<typename std::tuple_element<col_x, full_tuple_type>::type...> &row) {
+                tuple_utility::apply(visitor, row);
+            });
+        }
+
+        template<size_t...col_x, typename VISITOR>
+        SQLITE_API int SQLITE_STDCALL
+        parallel_scan_match_conditions(const sqlite_tool::sqlite3_condition &condition, VISITOR &&visitor, size_t workers = 0) {
+            size_t range_count = 0;
+            return parallel_scan_where<col_x...>(condition.render(columns), condition.parameters(), workers, range_count, [&visitor](size_t, std::tuple<typename std::tuple_element<col_x, full_tuple_type>::type...> &row) {
+                tuple_utility::apply(visitor, row);
+            });
+        }
+
+        /**
+         *parallel counterpart of get_column_value, the merged result is in rowid order; each range
+         *is its own snapshot, so under concurrent commits the result is not one consistent snapshot
+         */
+        template<size_t...col_x>
+        SQLITE_API int SQLITE_STDCALL
+        get_column_value_parallel(std::deque<std::tuple<typename std::tuple_element<col_x, full_tuple_type>::type...>> &result, size_t workers = 0) {
+            return get_column_value_parallel_where<col_x...>(std::string(), std::vector<sqlite_tool::bound_value>(), result, workers);
+        }
+
+        template<size_t...col_x>
+        SQLITE_API int SQLITE_STDCALL
+        get_column_value_parallel_match_conditions(std::deque<std::tuple<typename std::tuple_element<col_x, full_tuple_type>::type...>> &result, size_t workers = 0) {
+            return get_column_value_parallel_where<col_x...>(execute_conditions, condition_values, result, workers);
+        }
+
+        template<size_t...col_x>
+        SQLITE_API int SQLITE_STDCALL
+        get_column_value_parallel_match_conditions(const sqlite_tool::sqlite3_condition &condition, std::deque<std::tuple<typename std::tuple_element<col_x, full_tuple_type>::type...>> &result, size_t workers = 0) {
+            return get_column_value_parallel_where<col_x...>(condition.render(columns), condition.parameters(), result, workers);
+        }
+
+    public:
+        template<typename AGG, size_t col_x>
+        using aggregate_type = typename AGG::template result<typename std::tuple_element<col_x, full_tuple_type>::type>::type;
+        
+    private:
+        /**
+         *every result row decoded into a tuple, used for aggregate queries whose columns are not table columns
+         */
+        template<typename TUPLE>
+        SQLITE_API int SQLITE_STDCALL
+        select_tuples(const std::string &sqlcmd, const std::vector<sqlite_tool::bound_value> &values, std::vector<TUPLE> &result) {
+            sqlite_tool::operation_probe probe(instrumentation, sqlite_tool::operation_type::aggregate);
+            connection_lease lease = lease_reader();
             sqlite3_stmt *stmt = nullptr;
-            SQLITE_API int SQLITE_STDCALL prep_err = sqlite3_prepare_v2(sqdb, sqlcmd.c_str(), int(sqlcmd.size()), &stmt, NULL);
+            bool prepared = false;
+            probe.start();
+            SQLITE_API int SQLITE_STDCALL prep_err = lease.prepare(sqlcmd, &stmt, &prepared);
+            probe.prepared(prepared);
             if (prep_err != SQLITE_OK) {
                 return prep_err;
             }
+            probe.start();
+            SQLITE_API int SQLITE_STDCALL bind_err = bind_condition_values(stmt, values);
+            probe.bound();
+            if (bind_err != SQLITE_OK) {
+                lease.release(stmt);
+                return bind_err;
+            }
             
             SQLITE_API int SQLITE_STDCALL step_err = SQLITE_OK;
+            probe.start();
             while ((step_err = sqlite3_step(stmt)) == SQLITE_ROW) {
-                sqlite3_row current_row(db_row, db_row_size);
-                SQLITE_API int SQLITE_STDCALL col_size = sqlite3_column_count(stmt);
-                /**^The leftmost column of the result set has the index 0.
-                 */
-                for (int col_idx = 0; col_idx < col_size; col_idx++) {
-                    switch (sqlite3_column_type(stmt, col_idx)) {
-                        case SQLITE_INTEGER: {
-                            stmt_utility::stmt_get_column_to_row<sqlite_tool::integer>(stmt, col_idx, current_row);
-                            break;
-                        }
-                        case SQLITE_FLOAT: {
-                            stmt_utility::stmt_get_column_to_row<sqlite_tool::real>(stmt, col_idx, current_row);
-                            break;
-                        }
-                        case SQLITE_BLOB: {
-                            stmt_utility::stmt_get_column_to_row<sqlite_tool::data_string>(stmt, col_idx, current_row);
-                            break;
-                        }
-                        case SQLITE_TEXT: {
-                            stmt_utility::stmt_get_column_to_row<sqlite_tool::char_string>(stmt, col_idx, current_row);
-                            break;
-                        }
-                        case SQLITE_NULL: {
-                            const char *decl_type = sqlite3_column_decltype(stmt, col_idx);
-                            if (strcmp(decl_type, "TEXT") == 0) {
-                                current_row.set_column(col_idx, char_string(""));
-                            }
-                            else if (strcmp(decl_type, "INTEGER") == 0) {
-                                current_row.set_column(col_idx, sqlite3_int64(0));
-                            }
-                            else if (strcmp(decl_type, "REAL") == 0) {
-                                current_row.set_column(col_idx, double(0.0));
-                            }
-                            else if (strcmp(decl_type, "BLOB") == 0) {
-                                unsigned char nval = 0;
-                                current_row.set_column(col_idx, data_string(&nval, 1));
-                            }
-                            else {
-                                throw ;
-                            }
-                            break;
-                        }
-                        default:
-                            break;
-                    }//switch
-                }//for
-                result.emplace_back(std::move(current_row));
-            }//while
-            sqlite3_finalize(stmt);
+                probe.stepped(step_err);
+                result.emplace_back();
+                tuple_utility::get_row(stmt, result.back());
+                probe.start();
+            }
+            probe.stepped(step_err);
+            probe.statement(stmt);
+            lease.release(stmt);
             if (step_err == SQLITE_DONE) {
                 return SQLITE_OK;
             }
@@ -740,103 +6687,297 @@ namespace sqlite_tool {
             }
         }
         
-    public:
+        template<typename AGG, size_t col_x>
+        void
+        aggregate_command(std::string &sqlcmd) {
+            sqlcmd.append(AGG::function());
+            sqlcmd.append("(");
+            sqlcmd.append(columns.at(col_x));
+            sqlcmd.append(")");
+        }
+        
         /**
-         *get columns value uses static not dynamic run-time typing
+         *empty conditions aggregate the whole table; an empty table or group gives NULL, read back as 0 or empty
          */
-        template<size_t...col_x>
-        std::deque<std::tuple<typename std::tuple_element<col_x, full_tuple_type>::type...>>
-        get_column_value() {
-            std::deque<std::tuple<typename std::tuple_element<col_x, full_tuple_type>::type...>> return_queue;
-            std::string sqlcmd("SELECT * FROM ");
+        template<typename VALUE>
+        SQLITE_API int SQLITE_STDCALL
+        aggregate_where(const std::string &expression, const std::string &conditions, const std::vector<sqlite_tool::bound_value> &values, VALUE &result) {
+            std::string sqlcmd("SELECT ");
+            sqlcmd.append(expression);
+            sqlcmd.append(" FROM ");
             sqlcmd.append(table);
+            if (!conditions.empty()) {
+                sqlcmd.append(" WHERE ");
+                sqlcmd.append(conditions);
+            }
+            std::vector<std::tuple<VALUE>> rows;
+            SQLITE_API int SQLITE_STDCALL err = select_tuples(sqlcmd, values, rows);
+            result = err != SQLITE_OK || rows.empty() ? VALUE() : std::get<0>(rows.front());
+            return err;
+        }
+        
+        template<typename VALUE>
+        VALUE
+        aggregate_where(const std::string &expression, const std::string &conditions, const std::vector<sqlite_tool::bound_value> &values) {
+            VALUE result = VALUE();
+            aggregate_where(expression, conditions, values, result);
+            return result;
+        }
+        
+    public:
+        /**
+         *computed inside SQLite, one row comes back: sq_delegate.aggregate<sqlite_tool::agg::sum, 1>();
+         *the overloads taking result return the SQLite result code, the others read an error as 0 or empty
+         */
+        template<typename AGG, size_t col_x>
+        aggregate_type<AGG, col_x>
+        aggregate() {
+            std::string expression;
+            aggregate_command<AGG, col_x>(expression);
+            return aggregate_where<aggregate_type<AGG, col_x>>(expression, std::string(), std::vector<sqlite_tool::bound_value>());
+        }
+        
+        template<typename AGG, size_t col_x>
+        SQLITE_API int SQLITE_STDCALL
+        aggregate(aggregate_type<AGG, col_x> &result) {
+            std::string expression;
+            aggregate_command<AGG, col_x>(expression);
+            return aggregate_where(expression, std::string(), std::vector<sqlite_tool::bound_value>(), result);
+        }
+        
+        template<typename AGG, size_t col_x>
+        aggregate_type<AGG, col_x>
+        aggregate_match_conditions() {
+            std::string expression;
+            aggregate_command<AGG, col_x>(expression);
+            return aggregate_where<aggregate_type<AGG, col_x>>(expression, execute_conditions, condition_values);
+        }
+        
+        template<typename AGG, size_t col_x>
+        aggregate_type<AGG, col_x>
+        aggregate_match_conditions(const sqlite_tool::sqlite3_condition &condition) {
+            std::string expression;
+            aggregate_command<AGG, col_x>(expression);
+            return aggregate_where<aggregate_type<AGG, col_x>>(expression, condition.render(columns), condition.parameters());
+        }
+        
+        template<typename AGG, size_t col_x>
+        SQLITE_API int SQLITE_STDCALL
+        aggregate_match_conditions(const sqlite_tool::sqlite3_condition &condition, aggregate_type<AGG, col_x> &result) {
+            std::string expression;
+            aggregate_command<AGG, col_x>(expression);
+            return aggregate_where(expression, condition.render(columns), condition.parameters(), result);
+        }
+        
+        /**
+         *number of rows matching, not of non-NULL values (use aggregate<agg::count, col> for that)
+         */
+        sqlite_tool::integer
+        count_match_conditions() {
+            return aggregate_where<sqlite_tool::integer>("count(*)", execute_conditions, condition_values);
+        }
+        
+        sqlite_tool::integer
+        count_match_conditions(const sqlite_tool::sqlite3_condition &condition) {
+            return aggregate_where<sqlite_tool::integer>("count(*)", condition.render(columns), condition.parameters());
+        }
+        
+        SQLITE_API int SQLITE_STDCALL
+        count_match_conditions(const sqlite_tool::sqlite3_condition &condition, sqlite_tool::integer &count) {
+            return aggregate_where("count(*)", condition.render(columns), condition.parameters(), count);
+        }
+        
+        /**
+         *aggregates per distinct value of column key_col, rows come back ordered by the key:
+         *auto totals = sq_delegate.group_by<0>().where(col<1>() > 0.0).sum<1>();
+         *aggregate(rows) and count(rows) return the SQLite result code, the others read an error as no groups
+         */
+        template<size_t key_col>
+        class group_query {
+        public:
+            typedef typename std::tuple_element<key_col, full_tuple_type>::type key_type;
             
-            if (sqdb == nullptr) {
-                SQLITE_API int SQLITE_STDCALL open_err = open_db();
-                if (open_err != SQLITE_OK) {
-                    return return_queue;
+            template<typename AGG, size_t col_x>
+            using rows_type = std::vector<std::tuple<key_type, aggregate_type<AGG, col_x>>>;
+        private:
+            sqlite3_delegate *owner;
+            std::string conditions;
+            std::vector<sqlite_tool::bound_value> values;
+            
+            template<typename VALUE>
+            SQLITE_API int SQLITE_STDCALL
+            run(const std::string &expression, std::vector<std::tuple<key_type, VALUE>> &rows) const {
+                const std::string &key = owner->columns.at(key_col);
+                std::string sqlcmd("SELECT ");
+                sqlcmd.append(key);
+                sqlcmd.append(",");
+                sqlcmd.append(expression);
+                sqlcmd.append(" FROM ");
+                sqlcmd.append(owner->table);
+                if (!conditions.empty()) {
+                    sqlcmd.append(" WHERE ");
+                    sqlcmd.append(conditions);
                 }
+                sqlcmd.append(" GROUP BY ");
+                sqlcmd.append(key);
+                sqlcmd.append(" ORDER BY ");
+                sqlcmd.append(key);
+                rows.clear();
+                return owner->select_tuples(sqlcmd, values, rows);
             }
             
-            sqlite3_stmt *stmt;
-            SQLITE_API int SQLITE_STDCALL prep_err = sqlite3_prepare_v2(sqdb, sqlcmd.c_str(), int(sqlcmd.size()), &stmt, NULL);
-            if (prep_err != SQLITE_OK) {
-                return return_queue;
+            template<typename VALUE>
+            std::vector<std::tuple<key_type, VALUE>>
+            run(const std::string &expression) const {
+                std::vector<std::tuple<key_type, VALUE>> rows;
+                if (run(expression, rows) != SQLITE_OK) {
+                    rows.clear();
+                }
+                return rows;
+            }
+        public:
+            explicit group_query(sqlite3_delegate *owner) : owner(owner) {
+                
             }
             
-            SQLITE_API int SQLITE_STDCALL step_err = SQLITE_OK;
-            while ((step_err = sqlite3_step(stmt)) == SQLITE_ROW) {
-                auto &&row = std::make_tuple(stmt_utility::stmt_get_column<typename std::tuple_element<col_x, full_tuple_type>::type>(stmt, col_x)...);
-                return_queue.emplace_back(std::move(row));
+            group_query &
+            where(const sqlite_tool::sqlite3_condition &condition) {
+                conditions = condition.render(owner->columns);
+                values = condition.parameters();
+                return *this;
             }
             
-            sqlite3_finalize(stmt);
-            if (step_err != SQLITE_DONE) {
-                //throw ;
+            template<typename AGG, size_t col_x>
+            rows_type<AGG, col_x>
+            aggregate() const {
+                std::string expression;
+                owner->template aggregate_command<AGG, col_x>(expression);
+                return run<aggregate_type<AGG, col_x>>(expression);
             }
             
-            return return_queue;
-        }
-        
-        template<size_t...col_x>
-        std::deque<std::tuple<typename std::tuple_element<col_x, full_tuple_type>::type...>>
-        get_column_value_match_conditions() {
-            std::deque<std::tuple<typename std::tuple_element<col_x, full_tuple_type>::type...>> return_queue;
-            std::string sqlcmd("SELECT * FROM ");
-            sqlcmd.append(table);
-            sqlcmd.append(" WHERE ");
-            sqlcmd.append(execute_conditions);
+            template<typename AGG, size_t col_x>
+            SQLITE_API int SQLITE_STDCALL
+            aggregate(rows_type<AGG, col_x> &rows) const {
+                std::string expression;
+                owner->template aggregate_command<AGG, col_x>(expression);
+                return run(expression, rows);
+            }
             
-            if (sqdb == nullptr) {
-                SQLITE_API int SQLITE_STDCALL open_err = open_db();
-                if (open_err != SQLITE_OK) {
-                    return return_queue;
-                }
+            std::vector<std::tuple<key_type, sqlite_tool::integer>>
+            count() const {
+                return run<sqlite_tool::integer>("count(*)");
             }
             
-            sqlite3_stmt *stmt;
-            SQLITE_API int SQLITE_STDCALL prep_err = sqlite3_prepare_v2(sqdb, sqlcmd.c_str(), int(sqlcmd.size()), &stmt, NULL);
-            if (prep_err != SQLITE_OK) {
-                return return_queue;
+            SQLITE_API int SQLITE_STDCALL
+            count(std::vector<std::tuple<key_type, sqlite_tool::integer>> &rows) const {
+                return run("count(*)", rows);
             }
             
-            SQLITE_API int SQLITE_STDCALL step_err = SQLITE_OK;
-            while ((step_err = sqlite3_step(stmt)) == SQLITE_ROW) {
-                auto &&row = std::make_tuple(stmt_utility::stmt_get_column<typename std::tuple_element<col_x, full_tuple_type>::type>(stmt, col_x)...);
-                return_queue.emplace_back(std::move(row));
+            template<size_t col_x>
+            rows_type<sqlite_tool::agg::sum, col_x>
+            sum() const {
+                return aggregate<sqlite_tool::agg::sum, col_x>();
             }
             
-            sqlite3_finalize(stmt);
-            if (step_err != SQLITE_DONE) {
-                //throw ;
+            template<size_t col_x>
+            rows_type<sqlite_tool::agg::avg, col_x>
+            avg() const {
+                return aggregate<sqlite_tool::agg::avg, col_x>();
+            }
+            
+            template<size_t col_x>
+            rows_type<sqlite_tool::agg::min, col_x>
+            min() const {
+                return aggregate<sqlite_tool::agg::min, col_x>();
             }
             
-            return return_queue;
+            template<size_t col_x>
+            rows_type<sqlite_tool::agg::max, col_x>
+            max() const {
+                return aggregate<sqlite_tool::agg::max, col_x>();
+            }
+        };
+        
+        template<size_t key_col>
+        group_query<key_col>
+        group_by() {
+            return group_query<key_col>(this);
         }
-
+        
+    private:
+        sqlite_tool::query_plan
+        explain_where(const std::string &conditions, const std::vector<sqlite_tool::bound_value> &values) {
+            sqlite_tool::query_plan plan;
+            std::string sqlcmd("EXPLAIN QUERY PLAN SELECT * FROM ");
+            sqlcmd.append(table);
+            sqlcmd.append(" WHERE ");
+            sqlcmd.append(conditions);
+            connection_lease lease = lease_reader();
+            sqlite3_stmt *stmt = nullptr;
+            if (lease.prepare(sqlcmd, &stmt) != SQLITE_OK) {
+                return plan;
+            }
+            if (bind_condition_values(stmt, values) == SQLITE_OK) {
+                while (sqlite3_step(stmt) == SQLITE_ROW) {
+                    sqlite_tool::query_plan::step item;
+                    item.id = sqlite3_column_int(stmt, 0);
+                    item.parent = sqlite3_column_int(stmt, 1);
+                    stmt_utility::stmt_get_column(stmt, 3, item.detail);
+                    plan.steps.emplace_back(std::move(item));
+                }
+            }
+            lease.release(stmt);
+            return plan;
+        }
+        
     public:
+        /**
+         *how SQLite would run a query filtered by condition, e.g. a startup check
+         *if (sq_delegate.explain(col<0>() == 3).full_scan()) { ... }
+         *an empty plan means the sql did not prepare
+         */
+        sqlite_tool::query_plan
+        explain(const sqlite_tool::sqlite3_condition &condition) {
+            return explain_where(condition.render(columns), condition.parameters());
+        }
+        
+        sqlite_tool::query_plan
+        explain_match_conditions() {
+            return explain_where(execute_conditions, condition_values);
+        }
+
+    private:
         SQLITE_API int SQLITE_STDCALL
-        delete_rows_match_conditions() {
+        delete_rows_where(const std::string &conditions, const std::vector<sqlite_tool::bound_value> &values) {
+            sqlite_tool::operation_probe probe(instrumentation, sqlite_tool::operation_type::delete_rows_match_conditions);
             std::string sqlcmd("DELETE FROM ");
             sqlcmd.append(table);
             sqlcmd.append(" WHERE ");
-            sqlcmd.append(execute_conditions);
-
-            if (sqdb == nullptr) {
-                SQLITE_API int SQLITE_STDCALL open_err = open_db();
-                if (open_err != SQLITE_OK) {
-                    return open_err;
-                }
-            }
+            sqlcmd.append(conditions);
 
             sqlite3_stmt *stmt = nullptr;
-            SQLITE_API int SQLITE_STDCALL prep_err = sqlite3_prepare_v2(sqdb, sqlcmd.c_str(), int(sqlcmd.size()), &stmt, NULL);
+            bool prepared = false;
+            probe.start();
+            SQLITE_API int SQLITE_STDCALL prep_err = prepare_statement(sqlcmd, &stmt, &prepared);
+            probe.prepared(prepared);
             if (prep_err != SQLITE_OK) {
                 return prep_err;
             }
 
+            probe.start();
+            SQLITE_API int SQLITE_STDCALL bind_err = bind_condition_values(stmt, values);
+            probe.bound();
+            if (bind_err != SQLITE_OK) {
+                statements.release(stmt);
+                return bind_err;
+            }
+
+            probe.start();
             SQLITE_API int SQLITE_STDCALL step_err = sqlite3_step(stmt);
-            sqlite3_finalize(stmt);
+            probe.stepped(step_err);
+            probe.statement(stmt);
+            statements.release(stmt);
+            settle_changes(step_err);
             if (step_err != SQLITE_DONE) {
                 return step_err;
             }
@@ -844,6 +6985,191 @@ namespace sqlite_tool {
             return SQLITE_OK;
         }
 
+    public:
+        SQLITE_API int SQLITE_STDCALL
+        delete_rows_match_conditions() {
+            return delete_rows_where(execute_conditions, condition_values);
+        }
+
+        SQLITE_API int SQLITE_STDCALL
+        delete_rows_match_conditions(const sqlite_tool::sqlite3_condition &condition) {
+            return delete_rows_where(condition.render(columns), condition.parameters());
+        }
+
+    public:
+        /**
+         *async writer mode: the *_async methods queue the write and return at once, a dedicated
+         *thread applies queued writes in group commits, and each future resolves with the
+         *write's result code after its transaction committed; while the writer runs the
+         *delegate's connection belongs to it, so do not call the synchronous write methods,
+         *and run concurrent queries through open_reader_pool
+         */
+        SQLITE_API int SQLITE_STDCALL
+        start_async_writer(const sqlite_tool::async_writer_options &options = sqlite_tool::async_writer_options()) {
+            if (executor) {
+                return SQLITE_MISUSE;
+            }
+            writer.reset();
+            if (sqdb == nullptr) {
+                SQLITE_API int SQLITE_STDCALL open_err = open_db();
+                if (open_err != SQLITE_OK) {
+                    return open_err;
+                }
+            }
+            writer.reset(new sqlite_tool::async_writer([this](const char *sqlcmd) {
+                return execute_sql(sqlcmd);
+            }, options));
+            return SQLITE_OK;
+        }
+        
+        /**
+         *waits until every queued write has committed
+         */
+        void
+        stop_async_writer() {
+            writer.reset();
+        }
+        
+        template<typename COLTP, typename...VALTP>
+        std::future<int>
+        put_row_async(std::pair<COLTP, VALTP>...pair) {
+            return submit_async_write([this, pair...]() {
+                return put_row(pair...);
+            });
+        }
+        
+        template<typename COLTP, typename...VALTP>
+        std::future<int>
+        update_column_value_match_conditions_async(const sqlite_tool::sqlite3_condition &condition, std::pair<COLTP, VALTP>...pair) {
+            std::string conditions = condition.render(columns);
+            std::vector<sqlite_tool::bound_value> values = condition.parameters();
+            return submit_async_write([this, conditions, values, pair...]() {
+                return update_column_value_where(conditions, values, pair...);
+            });
+        }
+        
+        std::future<int>
+        delete_rows_match_conditions_async(const sqlite_tool::sqlite3_condition &condition) {
+            std::string conditions = condition.render(columns);
+            std::vector<sqlite_tool::bound_value> values = condition.parameters();
+            return submit_async_write([this, conditions, values]() {
+                return delete_rows_where(conditions, values);
+            });
+        }
+        
+    private:
+        std::future<int>
+        submit_async_write(sqlite_tool::async_writer::operation op) {
+            if (!writer) {
+                std::promise<int> not_started;
+                not_started.set_value(SQLITE_MISUSE);
+                return not_started.get_future();
+            }
+            return writer->submit(std::move(op));
+        }
+        
+#if SQLXX_HAS_COROUTINES
+    public:
+        /**
+         *awaitable mode: the *_await methods return at once and run when co_awaited on a dedicated
+         *executor, writes on one thread that owns the delegate's connection, queries on read_threads
+         *threads when the reader pool is open (on the write thread otherwise); while it runs do not
+         *call the synchronous methods, it cannot be combined with start_async_writer
+         */
+        SQLITE_API int SQLITE_STDCALL
+        start_executor(const sqlite_tool::executor_options &options = sqlite_tool::executor_options()) {
+            if (writer) {
+                return SQLITE_MISUSE;
+            }
+            executor.reset();
+            if (sqdb == nullptr) {
+                SQLITE_API int SQLITE_STDCALL open_err = open_db();
+                if (open_err != SQLITE_OK) {
+                    return open_err;
+                }
+            }
+            executor.reset(new sqlite_tool::query_executor(options));
+            return SQLITE_OK;
+        }
+        
+        /**
+         *finishes every operation already awaited
+         */
+        void
+        stop_executor() {
+            executor.reset();
+        }
+        
+        template<size_t...col_x>
+        sqlite_tool::sqlite3_awaitable<std::deque<std::tuple<typename std::tuple_element<col_x, full_tuple_type>::type...>>>
+        get_column_value_await() {
+            return {executor.get(), readers.size() == 0, [this]() {
+                return get_column_value<col_x...>();
+            }};
+        }
+        
+        template<size_t...col_x>
+        sqlite_tool::sqlite3_awaitable<std::deque<std::tuple<typename std::tuple_element<col_x, full_tuple_type>::type...>>>
+        get_column_value_match_conditions_await(const sqlite_tool::sqlite3_condition &condition) {
+            return {executor.get(), readers.size() == 0, [this, condition]() {
+                return get_column_value_match_conditions<col_x...>(condition);
+            }};
+        }
+        
+        /**
+         *co_await yields batches of up to batch_rows rows, the executor steps one batch per await
+         */
+        template<size_t...col_x>
+        sqlite_tool::sqlite3_batch_cursor<typename std::tuple_element<col_x, full_tuple_type>::type...>
+        scan_await(size_t batch_rows) {
+            return {executor.get(), readers.size() == 0, batch_rows, [this]() {
+                return scan<col_x...>();
+            }};
+        }
+        
+        template<size_t...col_x>
+        sqlite_tool::sqlite3_batch_cursor<typename std::tuple_element<col_x, full_tuple_type>::type...>
+        scan_match_conditions_await(const sqlite_tool::sqlite3_condition &condition, size_t batch_rows) {
+            return {executor.get(), readers.size() == 0, batch_rows, [this, condition]() {
+                return scan_match_conditions<col_x...>(condition);
+            }};
+        }
+        
+        template<typename COLTP, typename...VALTP>
+        sqlite_tool::sqlite3_awaitable<int>
+        put_row_await(std::pair<COLTP, VALTP>...pair) {
+            return {executor.get(), true, [this, pair...]() {
+                return put_row(pair...);
+            }};
+        }
+        
+        /**
+         *rows are copied, the executor inserts them like put_rows
+         */
+        template<typename RANGE>
+        sqlite_tool::sqlite3_awaitable<int>
+        put_rows_await(const RANGE &rows, const sqlite_tool::batch_options &options = sqlite_tool::batch_options()) {
+            return {executor.get(), true, [this, rows, options]() {
+                return put_rows(rows, nullptr, options);
+            }};
+        }
+        
+        template<typename COLTP, typename...VALTP>
+        sqlite_tool::sqlite3_awaitable<int>
+        update_column_value_match_conditions_await(const sqlite_tool::sqlite3_condition &condition, std::pair<COLTP, VALTP>...pair) {
+            return {executor.get(), true, [this, condition, pair...]() {
+                return update_column_value_match_conditions(condition, pair...);
+            }};
+        }
+        
+        sqlite_tool::sqlite3_awaitable<int>
+        delete_rows_match_conditions_await(const sqlite_tool::sqlite3_condition &condition) {
+            return {executor.get(), true, [this, condition]() {
+                return delete_rows_match_conditions(condition);
+            }};
+        }
+#endif
+        
     private:
         void
         append_delete_condition_and(std::string &sqlcmd, std::string &&condition) {
@@ -876,6 +7202,7 @@ namespace sqlite_tool {
         void
         set_conditions_match_all(T0 condition, TN...condn) {
             execute_conditions.clear();
+            condition_values.clear();
             append_delete_condition_and(execute_conditions, std::forward<T0>(condition), std::forward<TN>(condn)...);
         }
         
@@ -883,9 +7210,20 @@ namespace sqlite_tool {
         void
         set_conditions_match_any(T0 condition, TN...condn) {
             execute_conditions.clear();
+            condition_values.clear();
             append_delete_condition_or(execute_conditions, std::forward<T0>(condition), std::forward<TN>(condn)...);
         }
         
+        /**
+         *typed conditions, values are bound as parameters instead of being written into the sql;
+         *column names are resolved here, so set them before calling
+         */
+        void
+        where(const sqlite_tool::sqlite3_condition &condition) {
+            execute_conditions = condition.render(columns);
+            condition_values = condition.parameters();
+        }
+        
     private:
         template<typename T>
         void
@@ -925,36 +7263,53 @@ namespace sqlite_tool {
         template<typename COLTP, typename...VALTP>
         SQLITE_API int SQLITE_STDCALL
         update_column_value_match_conditions(std::pair<COLTP, VALTP>...pair) {
+            return update_column_value_where(execute_conditions, condition_values, pair...);
+        }
+        
+        template<typename COLTP, typename...VALTP>
+        SQLITE_API int SQLITE_STDCALL
+        update_column_value_match_conditions(const sqlite_tool::sqlite3_condition &condition, std::pair<COLTP, VALTP>...pair) {
+            return update_column_value_where(condition.render(columns), condition.parameters(), pair...);
+        }
+        
+    private:
+        template<typename COLTP, typename...VALTP>
+        SQLITE_API int SQLITE_STDCALL
+        update_column_value_where(const std::string &conditions, const std::vector<sqlite_tool::bound_value> &values, std::pair<COLTP, VALTP>...pair) {
+            sqlite_tool::operation_probe probe(instrumentation, sqlite_tool::operation_type::update_column_value_match_conditions);
             std::string sqlcmd("UPDATE ");
             sqlcmd.append(table);
             sqlcmd.append(" SET ");
             update_prepare_name_value(sqlcmd, std::forward<std::pair<COLTP, VALTP>>(pair)...);
             sqlcmd.append(" WHERE ");
-            sqlcmd.append(execute_conditions);
-            
-            if (sqdb == nullptr) {
-                SQLITE_API int SQLITE_STDCALL open_err = open_db();
-                if (open_err != SQLITE_OK) {
-                    return open_err;
-                }
-            }
+            sqlcmd.append(conditions);
             
             sqlite3_stmt *stmt = nullptr;
-            SQLITE_API int SQLITE_STDCALL prep_err = sqlite3_prepare_v2(sqdb, sqlcmd.c_str(), int(sqlcmd.size()), &stmt, NULL);
+            bool prepared = false;
+            probe.start();
+            SQLITE_API int SQLITE_STDCALL prep_err = prepare_statement(sqlcmd, &stmt, &prepared);
+            probe.prepared(prepared);
             if (prep_err != SQLITE_OK) {
                 return prep_err;
             }
             
+            probe.start();
             SQLITE_API int SQLITE_STDCALL bind_err = bind_utility::bind_value(stmt, std::forward<std::pair<std::string, VALTP>>(bind_column_index_transfer_to_name(pair))...);
+            if (bind_err == SQLITE_OK) {
+                bind_err = bind_condition_values(stmt, values);
+            }
+            probe.bound();
             if (bind_err != SQLITE_OK) {
-                sqlite3_clear_bindings(stmt);
-                sqlite3_finalize(stmt);
+                statements.release(stmt);
                 return bind_err;
             }
             
+            probe.start();
             SQLITE_API int SQLITE_STDCALL step_err = sqlite3_step(stmt);
-            sqlite3_clear_bindings(stmt);
-            sqlite3_finalize(stmt);
+            probe.stepped(step_err);
+            probe.statement(stmt);
+            statements.release(stmt);
+            settle_changes(step_err);
             if (step_err != SQLITE_DONE) {
                 return step_err;
             }
@@ -0,0 +1,52 @@
+//
+//  aggregate_test.cpp
+//  aggregates and group_by compute in SQLite, and report the result code when the query fails
+//
+
+#include "check.hpp"
+#include "sqlite_tool.hpp"
+
+using namespace sqlite_tool;
+
+typedef sqlite3_delegate<integer, real> delegate_type;
+
+int main() {
+    remove("aggregate.db");
+    delegate_type delegate;
+    delegate.set_db_file_path("aggregate.db");
+    delegate.set_table_name("t");
+    delegate.set_column_names(std::string("k"), std::string("v"));
+    CHECK(delegate.create_table_if_not_exists() == SQLITE_OK);
+    for (int index = 0; index < 9; index++) {
+        delegate.put_row(std::make_pair(size_t(0), integer(index % 3)), std::make_pair(size_t(1), real(index)));
+    }
+    
+    CHECK(delegate.aggregate<agg::sum, 1>() == 36.0);
+    CHECK(delegate.aggregate<agg::max, 1>() == 8.0);
+    CHECK(delegate.aggregate_match_conditions<agg::min, 1>(col<0>() == 2) == 2.0);
+    real average = 0.0;
+    CHECK(delegate.aggregate<agg::avg, 1>(average) == SQLITE_OK && average == 4.0);
+    integer matched = 0;
+    CHECK(delegate.count_match_conditions(col<1>() >= 4.0, matched) == SQLITE_OK && matched == 5);
+    
+    auto sums = delegate.group_by<0>().where(col<1>() > 0.0).sum<1>();
+    CHECK(sums.size() == 3);
+    CHECK(std::get<0>(sums.at(0)) == 0 && std::get<1>(sums.at(0)) == 9.0);
+    CHECK(std::get<0>(sums.at(2)) == 2 && std::get<1>(sums.at(2)) == 15.0);
+    std::vector<std::tuple<integer, integer>> counts;
+    CHECK(delegate.group_by<0>().count(counts) == SQLITE_OK && counts.size() == 3 && std::get<1>(counts.at(1)) == 3);
+    
+    sqlite3 *locker = nullptr;
+    CHECK(sqlite3_open("aggregate.db", &locker) == SQLITE_OK);
+    CHECK(sqlite3_exec(locker, "BEGIN EXCLUSIVE", NULL, NULL, NULL) == SQLITE_OK);
+    real total = -1.0;
+    CHECK(delegate.aggregate<agg::sum, 1>(total) == SQLITE_BUSY && total == 0.0);
+    CHECK(delegate.count_match_conditions(col<0>() == 1, matched) == SQLITE_BUSY);
+    CHECK(delegate.group_by<0>().count(counts) == SQLITE_BUSY && counts.empty());
+    delegate_type::group_query<0>::rows_type<agg::max, 1> maxima;
+    CHECK((delegate.group_by<0>().aggregate<agg::max, 1>(maxima)) == SQLITE_BUSY);
+    sqlite3_exec(locker, "ROLLBACK", NULL, NULL, NULL);
+    sqlite3_close(locker);
+    CHECK((delegate.group_by<0>().aggregate<agg::max, 1>(maxima)) == SQLITE_OK && maxima.size() == 3);
+    return 0;
+}
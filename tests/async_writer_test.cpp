@@ -0,0 +1,57 @@
+//
+//  async_writer_test.cpp
+//  concurrent submits are all drained, and a throwing operation fails only its own future
+//
+
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "check.hpp"
+#include "sqlite_tool.hpp"
+
+using namespace sqlite_tool;
+
+int main() {
+    sqlite3 *db = nullptr;
+    CHECK(sqlite3_open(":memory:", &db) == SQLITE_OK);
+    sqlite3_exec(db, "CREATE TABLE t(a)", NULL, NULL, NULL);
+    std::vector<std::future<int>> results;
+    {
+        async_writer_options options;
+        options.max_batch = 8;
+        async_writer writer([db](const char *sqlcmd) {
+            return sqlite3_exec(db, sqlcmd, NULL, NULL, NULL);
+        }, options);
+        std::mutex results_mutex;
+        std::vector<std::thread> producers;
+        for (int thread = 0; thread < 4; thread++) {
+            producers.emplace_back([&]() {
+                for (int index = 0; index < 2000; index++) {
+                    std::future<int> result = writer.submit([db, index]() -> int {
+                        if (index == 17) {
+                            throw std::runtime_error("operation failed");
+                        }
+                        return sqlite3_exec(db, "INSERT INTO t VALUES(1)", NULL, NULL, NULL);
+                    });
+                    std::lock_guard<std::mutex> lock(results_mutex);
+                    results.push_back(std::move(result));
+                }
+            });
+        }
+        for (std::thread &producer : producers) {
+            producer.join();
+        }
+    }
+    size_t thrown = 0;
+    for (std::future<int> &result : results) {
+        try {
+            CHECK(result.get() == SQLITE_OK);
+        } catch (const std::runtime_error &) {
+            thrown++;
+        }
+    }
+    CHECK(results.size() == 8000 && thrown == 4);
+    sqlite3_close(db);
+    return 0;
+}
@@ -0,0 +1,34 @@
+//
+//  backup_test.cpp
+//  a backup whose source stays locked gives up after busy_timeout instead of retrying forever
+//
+
+#include "check.hpp"
+#include "sqlite_tool.hpp"
+
+using namespace sqlite_tool;
+
+int main() {
+    remove("backup.db");
+    sqlite3 *source = nullptr;
+    sqlite3 *locker = nullptr;
+    sqlite3 *target = nullptr;
+    CHECK(sqlite3_open("backup.db", &source) == SQLITE_OK);
+    CHECK(sqlite3_exec(source, "CREATE TABLE t(a); INSERT INTO t VALUES(1)", NULL, NULL, NULL) == SQLITE_OK);
+    CHECK(sqlite3_open("backup.db", &locker) == SQLITE_OK);
+    CHECK(sqlite3_open(":memory:", &target) == SQLITE_OK);
+    
+    CHECK(sqlite3_exec(locker, "BEGIN EXCLUSIVE", NULL, NULL, NULL) == SQLITE_OK);
+    backup_options options;
+    options.busy_timeout = std::chrono::milliseconds(100);
+    auto started = std::chrono::steady_clock::now();
+    CHECK(backup_utility::backup(target, source, options) == SQLITE_BUSY);
+    CHECK(std::chrono::steady_clock::now() - started < std::chrono::seconds(5));
+    
+    CHECK(sqlite3_exec(locker, "COMMIT", NULL, NULL, NULL) == SQLITE_OK);
+    CHECK(backup_utility::backup(target, source, options) == SQLITE_OK);
+    sqlite3_close(target);
+    sqlite3_close(locker);
+    sqlite3_close(source);
+    return 0;
+}
@@ -0,0 +1,52 @@
+//
+//  blob_stream_test.cpp
+//  chunked blob reads visit every matching row, NULL values included, and stream writes land in place
+//
+
+#include <map>
+
+#include "check.hpp"
+#include "sqlite_tool.hpp"
+
+using namespace sqlite_tool;
+
+typedef sqlite3_delegate<integer, data_string> delegate_type;
+
+int main() {
+    remove("blob_stream.db");
+    delegate_type delegate;
+    delegate.set_db_file_path("blob_stream.db");
+    delegate.set_table_name("t");
+    delegate.set_column_names(std::string("a"), std::string("b"));
+    delegate.set_column_constraints(std::string("INTEGER"), std::string("BLOB"));
+    CHECK(delegate.create_table_if_not_exists() == SQLITE_OK);
+    CHECK(delegate.put_row(std::make_pair(size_t(0), integer(1)), std::make_pair(size_t(1), zero_blob(10))) == SQLITE_OK);
+    integer first = delegate.last_insert_rowid();
+    CHECK(delegate.put_row(std::make_pair(size_t(0), integer(2))) == SQLITE_OK);
+    CHECK(delegate.put_row(std::make_pair(size_t(0), integer(3)), std::make_pair(size_t(1), zero_blob(5))) == SQLITE_OK);
+    
+    blob_stream stream;
+    CHECK(delegate.open_blob<1>(stream, first, true) == SQLITE_OK);
+    CHECK(stream.size() == 10);
+    const any_mem_t bytes[] = {1, 2, 3};
+    CHECK(stream.write(bytes, 3, 8) == SQLITE_RANGE);
+    CHECK(stream.write(bytes, 3, 7) == SQLITE_OK);
+    stream.close();
+    
+    std::map<integer, size_t> seen;
+    size_t chunks = 0;
+    any_mem_t last = 0;
+    CHECK(delegate.read_blobs_match_conditions<1>(col<0>() > 0, 4,
+        [&](integer rowid, size_t offset, const any_mem_t *data, size_t size, size_t value_size) {
+            seen[rowid] = value_size;
+            chunks++;
+            if (size != 0) {
+                last = data[size - 1];
+            }
+            (void)offset;
+            return true;
+        }) == SQLITE_OK);
+    CHECK(seen.size() == 3 && seen[1] == 10 && seen[2] == 0 && seen[3] == 5);
+    CHECK(chunks == 3 + 1 + 2 && last == 0);
+    return 0;
+}
@@ -0,0 +1,67 @@
+//
+//  change_feed_busy_test.cpp
+//  a commit that fails with SQLITE_BUSY after the commit hook ran must not reach subscribers
+//
+
+#include "check.hpp"
+#include "sqlite_tool.hpp"
+
+using namespace sqlite_tool;
+
+typedef sqlite3_delegate<integer, char_string> delegate_type;
+typedef change_subscription<integer, char_string> subscription_type;
+
+/**
+ *a second connection in the middle of a read keeps a SHARED lock, so COMMIT cannot get EXCLUSIVE
+ */
+struct shared_lock {
+    sqlite3 *db = nullptr;
+    sqlite3_stmt *stmt = nullptr;
+    
+    explicit shared_lock(const char *path) {
+        CHECK(sqlite3_open(path, &db) == SQLITE_OK);
+        CHECK(sqlite3_prepare_v2(db, "SELECT a FROM t UNION ALL SELECT 0", -1, &stmt, NULL) == SQLITE_OK);
+        CHECK(sqlite3_step(stmt) == SQLITE_ROW);
+    }
+    
+    ~shared_lock() {
+        sqlite3_finalize(stmt);
+        sqlite3_close(db);
+    }
+};
+
+int main() {
+    remove("change_feed_busy.db");
+    delegate_type delegate;
+    delegate.set_db_file_path("change_feed_busy.db");
+    delegate.set_table_name("t");
+    delegate.set_column_names(std::string("a"), std::string("b"));
+    CHECK(delegate.create_table_if_not_exists() == SQLITE_OK);
+    std::unique_ptr<subscription_type> subscription;
+    CHECK(delegate.subscribe_changes(subscription) == SQLITE_OK);
+    subscription_type::batch batch;
+    
+    {
+        shared_lock reader("change_feed_busy.db");
+        CHECK(delegate.put_row(std::make_pair(size_t(0), integer(1))) == SQLITE_BUSY);
+    }
+    CHECK(subscription->next(batch, std::chrono::milliseconds(20)) == SQLITE_DONE);
+    
+    CHECK(delegate.start_async_writer() == SQLITE_OK);
+    {
+        shared_lock reader("change_feed_busy.db");
+        CHECK(delegate.put_row_async(std::make_pair(size_t(0), integer(2))).get() == SQLITE_BUSY);
+    }
+    CHECK(subscription->next(batch, std::chrono::milliseconds(20)) == SQLITE_DONE);
+    CHECK(delegate.put_row_async(std::make_pair(size_t(0), integer(3))).get() == SQLITE_OK);
+    delegate.stop_async_writer();
+    
+    CHECK(delegate.put_row(std::make_pair(size_t(0), integer(4))) == SQLITE_OK);
+    CHECK(subscription->next(batch, std::chrono::milliseconds(20)) == SQLITE_OK);
+    CHECK(batch.changes.size() == 1 && batch.changes.at(0).op == change_op::insert && batch.lost_commits == 0);
+    CHECK(subscription->next(batch, std::chrono::milliseconds(20)) == SQLITE_OK);
+    CHECK(batch.changes.size() == 1);
+    CHECK(subscription->next(batch, std::chrono::milliseconds(20)) == SQLITE_DONE);
+    CHECK(delegate.get_column_value<0>().size() == 2);
+    return 0;
+}
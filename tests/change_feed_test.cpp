@@ -0,0 +1,40 @@
+//
+//  change_feed_test.cpp
+//  changes undone by ROLLBACK TO must never reach subscribers
+//
+
+#include "check.hpp"
+#include "sqlite_tool.hpp"
+
+using namespace sqlite_tool;
+
+typedef sqlite3_delegate<integer, char_string> delegate_type;
+typedef change_subscription<integer, char_string> subscription_type;
+
+int main() {
+    remove("change_feed.db");
+    delegate_type delegate;
+    delegate.set_db_file_path("change_feed.db");
+    delegate.set_table_name("t");
+    delegate.set_column_names(std::string("a"), std::string("b"));
+    delegate.set_column_constraints(std::string("INTEGER UNIQUE"), std::string("TEXT"));
+    CHECK(delegate.create_table_if_not_exists() == SQLITE_OK);
+    std::unique_ptr<subscription_type> subscription;
+    CHECK(delegate.subscribe_changes(subscription) == SQLITE_OK);
+    
+    std::vector<std::tuple<integer, char_string>> conflicting{
+        std::make_tuple(integer(1), char_string("a")),
+        std::make_tuple(integer(2), char_string("b")),
+        std::make_tuple(integer(1), char_string("c"))
+    };
+    CHECK(delegate.put_rows(conflicting) == SQLITE_CONSTRAINT);
+    CHECK(delegate.get_column_value<0>().size() == 0);
+    subscription_type::batch batch;
+    CHECK(subscription->next(batch, std::chrono::milliseconds(20)) == SQLITE_DONE);
+    
+    std::vector<std::tuple<integer, char_string>> single{std::make_tuple(integer(5), char_string("x"))};
+    CHECK(delegate.put_rows(single) == SQLITE_OK);
+    CHECK(subscription->next(batch, std::chrono::milliseconds(20)) == SQLITE_OK);
+    CHECK(batch.changes.size() == 1 && batch.changes.at(0).op == change_op::insert);
+    return 0;
+}
@@ -0,0 +1,19 @@
+//
+//  check.hpp
+//  minimal assertion for the regression tests, active in every build type
+//
+
+#ifndef sqlite_tool_check_hpp
+#define sqlite_tool_check_hpp
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define CHECK(...) do { \
+    if (!(__VA_ARGS__)) { \
+        fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #__VA_ARGS__); \
+        exit(1); \
+    } \
+} while (0)
+
+#endif /* sqlite_tool_check_hpp */
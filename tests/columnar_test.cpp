@@ -0,0 +1,28 @@
+//
+//  columnar_test.cpp
+//  whole-table columnar fetch over sparse rowids must not reserve the rowid range
+//
+
+#include "check.hpp"
+#include "sqlite_tool.hpp"
+
+using namespace sqlite_tool;
+
+typedef sqlite3_delegate<integer, char_string> delegate_type;
+
+int main() {
+    remove("columnar.db");
+    delegate_type delegate;
+    delegate.set_db_file_path("columnar.db");
+    delegate.set_table_name("t");
+    delegate.set_column_names(std::string("a"), std::string("b"));
+    CHECK(delegate.create_table_if_not_exists() == SQLITE_OK);
+    sqlite3 *raw = nullptr;
+    CHECK(sqlite3_open("columnar.db", &raw) == SQLITE_OK);
+    CHECK(sqlite3_exec(raw, "INSERT INTO t(rowid, a, b) VALUES(1, 1, 'x'), (1099511627776, 2, 'y')", NULL, NULL, NULL) == SQLITE_OK);
+    sqlite3_close(raw);
+    delegate_type::columnar_type<0, 1> result;
+    CHECK(delegate.get_columnar<0, 1>(result) == SQLITE_OK);
+    CHECK(result.size() == 2);
+    return 0;
+}
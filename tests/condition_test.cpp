@@ -0,0 +1,31 @@
+//
+//  condition_test.cpp
+//  every arithmetic type binds in a typed condition, integral as INTEGER and floating point as REAL
+//
+
+#include "check.hpp"
+#include "sqlite_tool.hpp"
+
+using namespace sqlite_tool;
+
+typedef sqlite3_delegate<integer, real> delegate_type;
+
+int main() {
+    remove("condition.db");
+    delegate_type delegate;
+    delegate.set_db_file_path("condition.db");
+    delegate.set_table_name("t");
+    delegate.set_column_names(std::string("a"), std::string("b"));
+    CHECK(delegate.create_table_if_not_exists() == SQLITE_OK);
+    for (int index = 0; index < 10; index++) {
+        delegate.put_row(std::make_pair(size_t(0), integer(index)), std::make_pair(size_t(1), real(index) + 0.5));
+    }
+    CHECK(delegate.count_match_conditions(col<0>() > 5u) == 4);
+    CHECK(delegate.count_match_conditions(col<0>() > size_t(5)) == 4);
+    CHECK(delegate.count_match_conditions(col<0>() > 5L) == 4);
+    CHECK(delegate.count_match_conditions(col<0>() >= short(5)) == 5);
+    CHECK(delegate.count_match_conditions(col<0>() == true) == 1);
+    CHECK(delegate.count_match_conditions(col<1>() < 2.5f) == 2);
+    CHECK(delegate.count_match_conditions(col<1>() > 8.0L) == 2);
+    return 0;
+}
@@ -0,0 +1,152 @@
+//
+//  executor_test.cpp
+//  awaitable mode: writes, queries and batched scans resume on the caller's loop, and work that
+//  throws resumes the coroutine with the exception; built as C++20
+//
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+
+#include "check.hpp"
+#include "sqlite_tool.hpp"
+
+#if SQLXX_HAS_COROUTINES
+using namespace sqlite_tool;
+
+typedef sqlite3_delegate<integer, char_string> delegate_type;
+
+struct task {
+    struct promise_type {
+        task get_return_object() { return {}; }
+        std::suspend_never initial_suspend() { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { CHECK(false); }
+    };
+};
+
+/**
+ *the caller's event loop, every continuation is posted here
+ */
+struct event_loop {
+    std::deque<std::function<void()>> continuations;
+    std::mutex continuations_mutex;
+    std::condition_variable wake;
+    
+    void
+    post(std::function<void()> continuation) {
+        {
+            std::lock_guard<std::mutex> lock(continuations_mutex);
+            continuations.push_back(std::move(continuation));
+        }
+        wake.notify_one();
+    }
+    
+    bool
+    run_one() {
+        std::function<void()> continuation;
+        {
+            std::unique_lock<std::mutex> lock(continuations_mutex);
+            if (!wake.wait_for(lock, std::chrono::seconds(5), [this]() { return !continuations.empty(); })) {
+                return false;
+            }
+            continuation = std::move(continuations.front());
+            continuations.pop_front();
+        }
+        continuation();
+        return true;
+    }
+};
+
+static std::thread::id loop_thread;
+static int finished = 0;
+
+static task
+write_and_scan(delegate_type &delegate) {
+    for (int index = 0; index < 20; index++) {
+        CHECK(co_await delegate.put_row_await(std::make_pair(size_t(0), integer(index)), std::make_pair(size_t(1), char_string("x"))) == SQLITE_OK);
+        CHECK(std::this_thread::get_id() == loop_thread);
+    }
+    std::vector<std::tuple<integer, char_string>> rows;
+    for (int index = 20; index < 1000; index++) {
+        rows.emplace_back(index, "y");
+    }
+    CHECK(co_await delegate.put_rows_await(rows) == SQLITE_OK);
+    auto all = co_await delegate.get_column_value_await<0, 1>();
+    CHECK(all.size() == 1000);
+    auto some = co_await delegate.get_column_value_match_conditions_await<0>(col<0>() < 10);
+    CHECK(some.size() == 10);
+    
+    auto scan = delegate.scan_await<0, 1>(128);
+    size_t scanned = 0;
+    size_t batches = 0;
+    while (co_await scan.next()) {
+        CHECK(scan.batch().size() <= 128);
+        CHECK(std::this_thread::get_id() == loop_thread);
+        scanned += scan.batch().size();
+        batches++;
+    }
+    CHECK(scan.error() == SQLITE_OK && scanned == 1000 && batches == 8);
+    finished++;
+}
+
+static task
+throwing_work(query_executor &executor) {
+    bool thrown = false;
+    try {
+        co_await sqlite3_awaitable<int>(&executor, true, []() -> int {
+            throw std::runtime_error("work failed");
+        });
+    } catch (const std::runtime_error &) {
+        thrown = true;
+    }
+    CHECK(thrown && std::this_thread::get_id() == loop_thread);
+    CHECK(co_await sqlite3_awaitable<int>(&executor, true, []() { return SQLITE_OK; }) == SQLITE_OK);
+    finished++;
+}
+
+int main() {
+    event_loop loop;
+    loop_thread = std::this_thread::get_id();
+    executor_options options;
+    options.resume = [&loop](std::function<void()> continuation) {
+        loop.post(std::move(continuation));
+    };
+    for (int pooled = 0; pooled < 2; pooled++) {
+        remove("executor.db");
+        remove("executor.db-wal");
+        remove("executor.db-shm");
+        delegate_type delegate;
+        delegate.set_db_file_path("executor.db");
+        delegate.set_table_name("t");
+        delegate.set_column_names(std::string("a"), std::string("b"));
+        CHECK(delegate.create_table_if_not_exists() == SQLITE_OK);
+        if (pooled) {
+            CHECK(delegate.open_reader_pool(2) == SQLITE_OK);
+        }
+        CHECK(delegate.start_executor(options) == SQLITE_OK);
+        finished = 0;
+        write_and_scan(delegate);
+        while (finished < 1) {
+            CHECK(loop.run_one());
+        }
+        delegate.stop_executor();
+    }
+    {
+        query_executor executor(options);
+        finished = 0;
+        throwing_work(executor);
+        while (finished < 1) {
+            CHECK(loop.run_one());
+        }
+    }
+    return 0;
+}
+#else
+int main() {
+    return 77;
+}
+#endif
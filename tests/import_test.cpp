@@ -0,0 +1,55 @@
+//
+//  import_test.cpp
+//  a binary record announcing more than max_record_bytes is rejected without being loaded
+//
+
+#include <string>
+
+#include "check.hpp"
+#include "sqlite_tool.hpp"
+
+using namespace sqlite_tool;
+
+typedef sqlite3_delegate<integer, char_string> delegate_type;
+
+static void
+put_le(std::string &out, uint64_t value, int bytes) {
+    for (int index = 0; index < bytes; index++) {
+        out.push_back(char(value >> (8 * index)));
+    }
+}
+
+int main() {
+    remove("import.db");
+    delegate_type delegate;
+    delegate.set_db_file_path("import.db");
+    delegate.set_table_name("t");
+    delegate.set_column_names(std::string("a"), std::string("b"));
+    CHECK(delegate.create_table_if_not_exists() == SQLITE_OK);
+    
+    std::string record;
+    put_le(record, 7, 8);
+    put_le(record, 3, 4);
+    record += "abc";
+    std::string input;
+    put_le(input, record.size(), 4);
+    input += record;
+    put_le(input, 100, 4);
+    input += std::string(100, 'z');
+    put_le(input, 0xfffffff0u, 4);
+    input += "xx";
+    FILE *file = fopen("import.bin", "wb");
+    CHECK(file != nullptr);
+    fwrite(input.data(), 1, input.size(), file);
+    fclose(file);
+    
+    import_report report;
+    import_options options;
+    options.format = import_format::binary;
+    options.max_record_bytes = 50;
+    CHECK(delegate.import_file("import.bin", report, options) == SQLITE_OK);
+    CHECK(report.imported == 1 && report.rejected == 2);
+    auto rows = delegate.get_column_value<0, 1>();
+    CHECK(rows.size() == 1 && std::get<0>(rows.at(0)) == 7 && std::get<1>(rows.at(0)) == "abc");
+    return 0;
+}
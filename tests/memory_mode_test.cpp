@@ -0,0 +1,48 @@
+//
+//  memory_mode_test.cpp
+//  an open transaction delays the flush only until it ends, and is reported once a flush is overdue
+//
+
+#include <thread>
+
+#include "check.hpp"
+#include "sqlite_tool.hpp"
+
+using namespace sqlite_tool;
+
+static int
+file_rows(const char *path) {
+    sqlite3 *db = nullptr;
+    int rows = -1;
+    sqlite3_open(path, &db);
+    sqlite3_exec(db, "SELECT count(*) FROM t", [](void *result, int, char **values, char **) -> int {
+        *reinterpret_cast<int *>(result) = atoi(values[0]);
+        return 0;
+    }, &rows, NULL);
+    sqlite3_close(db);
+    return rows;
+}
+
+int main() {
+    remove("memory_mode.db");
+    sqlite3 *memory_db = nullptr;
+    CHECK(sqlite3_open_v2(":memory:", &memory_db, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_FULLMUTEX, NULL) == SQLITE_OK);
+    {
+        memory_flusher flusher;
+        memory_mode_options options;
+        options.flush_interval = std::chrono::milliseconds(100);
+        CHECK(flusher.start(memory_db, "memory_mode.db", options) == SQLITE_OK);
+        sqlite3_exec(memory_db, "CREATE TABLE t(a)", NULL, NULL, NULL);
+        sqlite3_exec(memory_db, "BEGIN; INSERT INTO t VALUES(1)", NULL, NULL, NULL);
+        std::this_thread::sleep_for(std::chrono::milliseconds(350));
+        CHECK(flusher.error() == SQLITE_BUSY);
+        sqlite3_exec(memory_db, "COMMIT", NULL, NULL, NULL);
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        CHECK(file_rows("memory_mode.db") == 1);
+        CHECK(flusher.error() == SQLITE_OK);
+        sqlite3_exec(memory_db, "INSERT INTO t VALUES(2); BEGIN; INSERT INTO t VALUES(3)", NULL, NULL, NULL);
+    }
+    CHECK(file_rows("memory_mode.db") == 2);
+    sqlite3_close(memory_db);
+    return 0;
+}
@@ -0,0 +1,83 @@
+//
+//  page_test.cpp
+//  keyset pages over duplicate sort keys return every row exactly once and skip NULL keys
+//
+
+#include <set>
+
+#include "check.hpp"
+#include "sqlite_tool.hpp"
+
+using namespace sqlite_tool;
+
+typedef sqlite3_delegate<integer, integer> delegate_type;
+
+/**
+ *pages through the table and returns the ids seen, checking the sort order on the way
+ */
+template<typename PAGER>
+static std::multiset<integer>
+page_all(PAGER &&pager, size_t page_size, size_t &pages) {
+    std::multiset<integer> seen;
+    page_token<integer> token;
+    integer last_key = -1;
+    pages = 0;
+    for (;;) {
+        auto page = pager(token);
+        CHECK(page.error == SQLITE_OK);
+        CHECK(page.rows.size() <= page_size);
+        for (const auto &row : page.rows) {
+            CHECK(std::get<0>(row) >= last_key);
+            last_key = std::get<0>(row);
+            seen.insert(std::get<1>(row));
+        }
+        token = page.next;
+        if (page.rows.empty()) {
+            CHECK(token.finished);
+            break;
+        }
+        pages++;
+        if (token.finished) {
+            break;
+        }
+    }
+    return seen;
+}
+
+int main() {
+    remove("page.db");
+    delegate_type delegate;
+    delegate.set_db_file_path("page.db");
+    delegate.set_table_name("t");
+    delegate.set_column_names(std::string("k"), std::string("id"));
+    delegate.set_column_constraints(std::string("INTEGER"), std::string("INTEGER"));
+    CHECK(delegate.create_table_if_not_exists() == SQLITE_OK);
+    for (int index = 0; index < 100; index++) {
+        delegate.put_row(std::make_pair(size_t(0), integer(index % 7)), std::make_pair(size_t(1), integer(index)));
+    }
+    sqlite3 *raw = nullptr;
+    CHECK(sqlite3_open("page.db", &raw) == SQLITE_OK);
+    CHECK(sqlite3_exec(raw, "INSERT INTO t(k, id) VALUES(NULL, 1000), (NULL, 1001)", NULL, NULL, NULL) == SQLITE_OK);
+    sqlite3_close(raw);
+    
+    for (size_t page_size : {size_t(1), size_t(7), size_t(10), size_t(33), size_t(100), size_t(500)}) {
+        size_t pages = 0;
+        std::multiset<integer> seen = page_all([&](const page_token<integer> &after) {
+            return delegate.get_column_value_page<0, 0, 1>(page_size, after);
+        }, page_size, pages);
+        CHECK(seen.size() == 100 && *seen.begin() == 0 && *seen.rbegin() == 99);
+        CHECK(std::set<integer>(seen.begin(), seen.end()).size() == 100);
+        CHECK(pages == (100 + page_size - 1) / page_size);
+    }
+    
+    size_t pages = 0;
+    std::multiset<integer> filtered = page_all([&](const page_token<integer> &after) {
+        return delegate.get_column_value_match_conditions_page<0, 0, 1>(col<1>() >= 50, 5, after);
+    }, 5, pages);
+    CHECK(filtered.size() == 50 && *filtered.begin() == 50 && pages == 10);
+    
+    page_token<integer> done;
+    done.finished = true;
+    CHECK(delegate.get_column_value_page<0, 0, 1>(10, done).rows.empty());
+    return 0;
+}
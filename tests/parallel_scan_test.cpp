@@ -0,0 +1,76 @@
+//
+//  parallel_scan_test.cpp
+//  rowid range splitting returns every row once, for dense, sparse, single-row and empty tables,
+//  and a throwing visitor reaches the caller
+//
+
+#include <atomic>
+#include <stdexcept>
+
+#include "check.hpp"
+#include "sqlite_tool.hpp"
+
+using namespace sqlite_tool;
+
+typedef sqlite3_delegate<integer, char_string> delegate_type;
+
+static void
+reset_table(const char *rows_sql) {
+    sqlite3 *raw = nullptr;
+    CHECK(sqlite3_open("parallel_scan.db", &raw) == SQLITE_OK);
+    CHECK(sqlite3_exec(raw, "DELETE FROM t", NULL, NULL, NULL) == SQLITE_OK);
+    if (rows_sql != nullptr) {
+        CHECK(sqlite3_exec(raw, rows_sql, NULL, NULL, NULL) == SQLITE_OK);
+    }
+    sqlite3_close(raw);
+}
+
+static void
+check_rowid_order(delegate_type &delegate, size_t expected, size_t workers) {
+    std::deque<std::tuple<integer>> rows;
+    CHECK(delegate.get_column_value_parallel<0>(rows, workers) == SQLITE_OK);
+    CHECK(rows.size() == expected);
+    for (size_t index = 1; index < rows.size(); index++) {
+        CHECK(std::get<0>(rows.at(index - 1)) < std::get<0>(rows.at(index)));
+    }
+}
+
+int main() {
+    remove("parallel_scan.db");
+    delegate_type delegate;
+    delegate.set_db_file_path("parallel_scan.db");
+    delegate.set_table_name("t");
+    delegate.set_column_names(std::string("a"), std::string("b"));
+    CHECK(delegate.create_table_if_not_exists() == SQLITE_OK);
+    
+    check_rowid_order(delegate, 0, 4);
+    
+    reset_table("INSERT INTO t(rowid, a, b) VALUES(7, 7, 'x')");
+    check_rowid_order(delegate, 1, 4);
+    
+    reset_table("INSERT INTO t(rowid, a, b) VALUES(-9223372036854775807, 1, 'x'), (-5, 2, 'x'), (3, 3, 'x'), (1099511627776, 4, 'x'), (9223372036854775807, 5, 'x')");
+    check_rowid_order(delegate, 5, 4);
+    check_rowid_order(delegate, 5, 64);
+    
+    reset_table("WITH RECURSIVE n(i) AS (SELECT 1 UNION ALL SELECT i + 1 FROM n WHERE i < 5000) INSERT INTO t(rowid, a, b) SELECT i * 3, i, 'y' FROM n");
+    check_rowid_order(delegate, 5000, 3);
+    std::atomic<long long> total(0);
+    CHECK(delegate.parallel_scan_match_conditions<0>(col<0>() <= 100, [&total](integer value) {
+        total += value;
+    }, 4) == SQLITE_OK);
+    CHECK(total == 5050);
+    
+    bool thrown = false;
+    try {
+        delegate.parallel_scan<0>([](integer value) {
+            if (value == 2500) {
+                throw std::runtime_error("visitor failed");
+            }
+        }, 4);
+    } catch (const std::runtime_error &) {
+        thrown = true;
+    }
+    CHECK(thrown);
+    check_rowid_order(delegate, 5000, 4);
+    return 0;
+}
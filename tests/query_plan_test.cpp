@@ -0,0 +1,42 @@
+//
+//  query_plan_test.cpp
+//  only a table scan without an index counts as a full scan
+//
+
+#include "check.hpp"
+#include "sqlite_tool.hpp"
+
+using namespace sqlite_tool;
+
+typedef sqlite3_delegate<integer, integer> delegate_type;
+
+static query_plan
+single_step(const char *detail) {
+    query_plan plan;
+    query_plan::step item;
+    item.detail = detail;
+    plan.steps.push_back(item);
+    return plan;
+}
+
+int main() {
+    CHECK(single_step("SCAN t").full_scan());
+    CHECK(single_step("SCAN TABLE t").full_scan());
+    CHECK(!single_step("SCAN t").uses_index());
+    CHECK(!single_step("SCAN t USING COVERING INDEX t_a_idx").full_scan());
+    CHECK(single_step("SCAN t USING COVERING INDEX t_a_idx").uses_index());
+    CHECK(!single_step("SCAN t USING INDEX t_a_idx").full_scan());
+    CHECK(!single_step("SEARCH t USING INDEX t_a_idx (a=?)").full_scan());
+    
+    remove("query_plan.db");
+    delegate_type delegate;
+    delegate.set_db_file_path("query_plan.db");
+    delegate.set_table_name("t");
+    delegate.set_column_names(std::string("a"), std::string("b"));
+    delegate.add_index<0>();
+    CHECK(delegate.create_table_if_not_exists() == SQLITE_OK);
+    query_plan indexed = delegate.explain(col<0>() == 3);
+    CHECK(!indexed.full_scan() && indexed.uses_index());
+    CHECK(delegate.explain(col<1>() == 3).full_scan());
+    return 0;
+}
@@ -0,0 +1,59 @@
+//
+//  result_cache_test.cpp
+//  cached results must follow the value's storage class, other connections' writes and restores
+//
+
+#include "check.hpp"
+#include "sqlite_tool.hpp"
+
+using namespace sqlite_tool;
+
+typedef sqlite3_delegate<integer, real, char_string> delegate_type;
+
+static void
+setup(delegate_type &delegate, const char *path) {
+    remove(path);
+    delegate.set_db_file_path(path);
+    delegate.set_table_name("t");
+    delegate.set_column_names(std::string("a"), std::string("b"), std::string("s"));
+    CHECK(delegate.create_table_if_not_exists() == SQLITE_OK);
+}
+
+int main() {
+    {
+        delegate_type delegate;
+        setup(delegate, "result_cache_class.db");
+        delegate.put_row(std::make_pair(size_t(0), integer(1)), std::make_pair(size_t(2), char_string("1")));
+        delegate.put_row(std::make_pair(size_t(0), integer(2)), std::make_pair(size_t(2), char_string("1.0")));
+        CHECK(delegate.enable_result_cache(1 << 20) == SQLITE_OK);
+        auto as_integer = delegate.get_column_value_match_conditions<0>(col<2>() == integer(1));
+        auto as_real = delegate.get_column_value_match_conditions<0>(col<2>() == real(1.0));
+        CHECK(as_integer.size() == 1 && std::get<0>(as_integer.at(0)) == 1);
+        CHECK(as_real.size() == 1 && std::get<0>(as_real.at(0)) == 2);
+    }
+    {
+        delegate_type delegate;
+        setup(delegate, "result_cache_version.db");
+        delegate.put_row(std::make_pair(size_t(0), integer(1)));
+        CHECK(delegate.enable_result_cache(1 << 20) == SQLITE_OK);
+        CHECK(delegate.get_column_value<0>().size() == 1);
+        sqlite3 *other = nullptr;
+        CHECK(sqlite3_open("result_cache_version.db", &other) == SQLITE_OK);
+        CHECK(sqlite3_exec(other, "INSERT INTO t(a) VALUES(2)", NULL, NULL, NULL) == SQLITE_OK);
+        sqlite3_close(other);
+        CHECK(delegate.get_column_value<0>().size() == 2);
+    }
+    {
+        delegate_type delegate;
+        setup(delegate, "result_cache_restore.db");
+        delegate.put_row(std::make_pair(size_t(0), integer(1)));
+        memory_database snapshot;
+        CHECK(delegate.snapshot_to_memory(snapshot) == SQLITE_OK);
+        delegate.put_row(std::make_pair(size_t(0), integer(2)));
+        CHECK(delegate.enable_result_cache(1 << 20) == SQLITE_OK);
+        CHECK(delegate.get_column_value<0>().size() == 2);
+        CHECK(delegate.restore_from_memory(snapshot) == SQLITE_OK);
+        CHECK(delegate.get_column_value<0>().size() == 1);
+    }
+    return 0;
+}